@@ -0,0 +1,77 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "alloc_tracker.hpp"
+
+#include <cstdlib>
+#include <new>
+
+bool AllocTracker::isEnabled() { return ALLOC_TRACKING; }
+
+void AllocTracker::beginFrame() { GetFrames().start = Snapshot(); }
+
+// Frames that allocated at all are counted, the steady state should add none
+void AllocTracker::endFrame() {
+    Frames&    frames = GetFrames();
+    FrameStats now    = Snapshot();
+    frames.last.allocations = now.allocations - frames.start.allocations;
+    frames.last.bytes       = now.bytes       - frames.start.bytes;
+    frames.last.frees       = now.frees       - frames.start.frees;
+    if (frames.last.allocations > 0) frames.allocating++;
+}
+
+AllocTracker::FrameStats AllocTracker::getLastFrame() { return GetFrames().last; }
+uint64_t AllocTracker::getAllocatingFrames() { return GetFrames().allocating; }
+
+void AllocTracker::addAllocation(size_t size) {
+    Totals& totals = GetTotals();
+    totals.allocations.fetch_add(1, std::memory_order_relaxed);
+    totals.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void AllocTracker::addFree() { GetTotals().frees.fetch_add(1, std::memory_order_relaxed); }
+
+// Private ==================================================
+
+// Constant initialized, so counting works for allocations before main
+AllocTracker::Totals& AllocTracker::GetTotals() {
+    static Totals totals;
+    return totals;
+}
+
+AllocTracker::Frames& AllocTracker::GetFrames() {
+    static Frames frames;
+    return frames;
+}
+
+AllocTracker::FrameStats AllocTracker::Snapshot() {
+    Totals& totals = GetTotals();
+    FrameStats stats;
+    stats.allocations = totals.allocations.load(std::memory_order_relaxed);
+    stats.bytes       = totals.bytes      .load(std::memory_order_relaxed);
+    stats.frees       = totals.frees      .load(std::memory_order_relaxed);
+    return stats;
+}
+
+#if ALLOC_TRACKING
+
+// The library's nothrow forms call these, so they are counted too
+void* operator new(size_t size) {
+    AllocTracker::addAllocation(size);
+    void* ptr = malloc(size > 0 ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    AllocTracker::addFree();
+    free(ptr);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void  operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void  operator delete  (void* ptr, size_t) noexcept { operator delete(ptr); }
+void  operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+#endif
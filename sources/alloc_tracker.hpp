@@ -0,0 +1,56 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "include.h"
+
+#include <atomic>
+
+#ifdef NDEBUG
+#define ALLOC_TRACKING 0
+#else
+#define ALLOC_TRACKING 1
+#endif
+
+// Heap allocations per frame. Debug builds replace the global new and delete
+// to count them on every thread, including allocations the Vulkan driver or
+// GLFW make through new. ImGui allocates with malloc and is not counted.
+// Release builds keep the default operators and report nothing.
+class AllocTracker {
+
+public:
+    struct FrameStats {
+        uint64_t allocations = 0;
+        uint64_t bytes       = 0;
+        uint64_t frees       = 0;
+    };
+    
+    static bool isEnabled();
+    static void beginFrame();
+    static void endFrame();
+    static FrameStats getLastFrame();
+    static uint64_t   getAllocatingFrames();
+    
+    static void addAllocation(size_t size);
+    static void addFree();
+
+private:
+    struct Totals {
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> frees{0};
+    };
+    
+    // Only touched by the thread running the frame loop
+    struct Frames {
+        FrameStats start;
+        FrameStats last;
+        uint64_t   allocating = 0;
+    };
+    
+    static Totals& GetTotals();
+    static Frames& GetFrames();
+    static FrameStats Snapshot();
+
+};
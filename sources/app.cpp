@@ -5,12 +5,21 @@
 #include "include.h"
 #include "system.hpp"
 
+// Stalls of the setup are reported on their own, later reports cover the frames
 void App::run() {
     setup();
-    loop();
+    StallAuditor::report("startup");
+    if (m_headless) loopHeadless();
+    else            loop();
     cleanup();
 }
 
+void App::setBenchmark(Benchmark* pBenchmark) {
+    m_pBenchmark   = pBenchmark;
+    m_headless     = true;
+    m_headlessSize = pBenchmark->getScenario().size;
+}
+
 void App::cleanup() {
     System::Files()->cleanup();
     m_cleaner.flush("App");
@@ -29,12 +38,14 @@ void App::initDevice() {
     LOG("App::initDevice");
     Window* pWindow = m_pWindow;
     m_pDevice = new Device();
-    m_pDevice->setup();
+    m_pDevice->setup(m_headless);
     m_pDevice->createInstance();
     m_pDevice->createDebugMessenger();
-    m_pDevice->createSurface(pWindow->getGLFWwindow());
+    if (!m_headless) m_pDevice->createSurface(pWindow->getGLFWwindow());
     m_pDevice->selectPhysicalDevice();
     m_pDevice->createLogicalDevice();
+    m_pDevice->selectHDRFormats();
+    m_pDevice->createTimelines();
     System::Instance().setDevice(m_pDevice);
     m_cleaner.push([=](){ m_pDevice->cleanup(); });
 }
@@ -46,6 +57,19 @@ void App::initCommander() {
     m_pCommander->createPool();
     System::Instance().setCommander(m_pCommander);
     m_cleaner.push([=](){ m_pCommander->cleanup(); });
+    
+    m_pBakeCommander = new Commander();
+    m_pBakeCommander->setupPool(m_pDevice->getBackgroundTimeline(), m_pDevice->getGraphicQueueIndex());
+    m_pBakeCommander->createPool();
+    m_cleaner.push([=](){ m_pBakeCommander->cleanup(); });
+}
+
+void App::initDeletionQueue() {
+    LOG("App::initDeletionQueue");
+    m_pDeletionQueue = new DeletionQueue();
+    m_pDeletionQueue->create();
+    System::Instance().setDeletionQueue(m_pDeletionQueue);
+    m_cleaner.push([=](){ m_pDeletionQueue->cleanup(); });
 }
 
 void App::createGraphicsScreen() {
@@ -63,7 +87,8 @@ void App::createSwapchain() {
     LOG("App::createSwapchain");
     Renderpass* pRenderpass = m_pGraphicsScreen->getRenderpass();
     m_pSwapchain = new Swapchain();
-    m_pSwapchain->setup();
+    if (m_headless) m_pSwapchain->setupHeadless(m_headlessSize);
+    else            m_pSwapchain->setup();
     m_pSwapchain->create();
     m_pSwapchain->createFrames(pRenderpass);
     m_cleaner.push([=](){ m_pSwapchain->cleanup(); });
@@ -79,7 +104,7 @@ void App::createGUI() {
 
 void App::createGraphicsScene() {
     LOG("App::createGraphicsScene");
-    UInt2D size = m_pWindow->getFrameSize();
+    UInt2D size = m_headless ? m_headlessSize : m_pWindow->getFrameSize();
     m_pGraphicsScene = new GraphicsScene();
     m_pGraphicsScene->setupShader();
     m_pGraphicsScene->createDescriptor();
@@ -88,6 +113,7 @@ void App::createGraphicsScene() {
     m_pGraphicsScene->createRenderpass();
     m_pGraphicsScene->createPipelineLayout();
     m_pGraphicsScene->createPipeline();
+    m_pGraphicsScene->setupRenderGraph(m_pFrameGraph);
     m_pGraphicsScene->createFrame(size);
     m_cleaner.push([=](){ m_pGraphicsScene->cleanup(); });
     
@@ -105,10 +131,80 @@ void App::createComputeFluid() {
     m_pComputeFluid->createPipeline();
     m_cleaner.push([=](){ m_pComputeFluid->cleanup(); });
     
-    m_pGraphicsScene->updateHeightmapInput(m_pComputeFluid->getHeightImage());
-    m_pGUI->updateFluidImage(m_pComputeFluid->getFluidImage());
-    m_pGUI->updateHeightMapImage(m_pComputeFluid->getHeightImage());
-    m_pGUI->updateIridescentImage(m_pComputeFluid->getIridescentImage());
+    m_pGraphicsScene->updateHeightmapInput(m_pComputeFluid->getHeightImages());
+    if (!m_pGUI) return;
+    m_pGUI->updateFluidImages(m_pComputeFluid->getFluidImages());
+    m_pGUI->updateHeightMapImages(m_pComputeFluid->getHeightImages());
+    m_pGUI->updateIridescentImages(m_pComputeFluid->getIridescentImages());
+}
+
+void App::createAsyncCompute() {
+    LOG("App::createAsyncCompute");
+    m_pAsyncCompute = new AsyncCompute();
+    m_pAsyncCompute->setup();
+    m_pAsyncCompute->create();
+    m_cleaner.push([=](){ m_pAsyncCompute->cleanup(); });
+}
+
+// One profiler per command stream: the frame and compute ones cycle with the
+// frames in flight, bakes are one-off submissions timed through the commanders
+void App::createProfilers() {
+    LOG("App::createProfilers");
+    m_pFrameProfiler = new GPUProfiler();
+    m_pFrameProfiler->setup("Frame", m_pDevice->getGraphicQueueIndex(), MAX_FRAMES_IN_FLIGHT, 16);
+    m_pFrameProfiler->create();
+    m_cleaner.push([=](){ m_pFrameProfiler->cleanup(); });
+    
+    m_pComputeProfiler = new GPUProfiler();
+    m_pComputeProfiler->setup("Compute", m_pDevice->getComputeQueueIndex(), MAX_FRAMES_IN_FLIGHT, 16);
+    m_pComputeProfiler->create();
+    m_cleaner.push([=](){ m_pComputeProfiler->cleanup(); });
+    
+    m_pBakeProfiler = new GPUProfiler();
+    m_pBakeProfiler->setup("Bake", m_pDevice->getGraphicQueueIndex(), 1, 32);
+    m_pBakeProfiler->create();
+    m_cleaner.push([=](){ m_pBakeProfiler->cleanup(); });
+    
+    m_pCommander->setProfiler(m_pBakeProfiler);
+    m_pBakeCommander->setProfiler(m_pBakeProfiler);
+    HitchRecorder::addProfiler(m_pFrameProfiler);
+    HitchRecorder::addProfiler(m_pComputeProfiler);
+    HitchRecorder::addProfiler(m_pBakeProfiler);
+    if (m_pBenchmark) {
+        m_pBenchmark->addProfiler(m_pFrameProfiler);
+        m_pBenchmark->addProfiler(m_pComputeProfiler);
+    }
+    if (!m_pGUI) return;
+    m_pGUI->addProfiler(m_pFrameProfiler);
+    m_pGUI->addProfiler(m_pComputeProfiler);
+    m_pGUI->addProfiler(m_pBakeProfiler);
+}
+
+// The pass order of each graph is its submission order. The compute graph is
+// recorded for the async compute queue, the frame graph for graphics.
+void App::createRenderGraphs() {
+    LOG("App::createRenderGraphs");
+    m_pComputeGraph = new RenderGraph();
+    m_pComputeGraph->setupPasses({ "fluid", "fluid copy", "rain" });
+    m_pComputeGraph->setProfiler(m_pComputeProfiler);
+    m_cleaner.push([=](){ m_pComputeGraph->cleanup(); });
+    
+    m_pFrameGraph = new RenderGraph();
+    m_pFrameGraph->setupPasses({ "mark clear", "scene", "marking", "screen" });
+    m_pFrameGraph->setProfiler(m_pFrameProfiler);
+    m_cleaner.push([=](){ m_pFrameGraph->cleanup(); });
+}
+
+// Scene, screen and the compute submission are recorded by workers, the
+// main thread is left with the primary and the GUI
+void App::createRecorder() {
+    LOG("App::createRecorder");
+    uint coreCount   = std::thread::hardware_concurrency();
+    uint threadCount = coreCount > 4 ? 3 : (coreCount > 1 ? coreCount - 1 : 1);
+    m_pRecorder = new Recorder();
+    m_pRecorder->setup(threadCount);
+    m_pRecorder->create();
+    m_cleaner.push([=](){ m_pRecorder->cleanup(); });
 }
 
 void App::createComputeMarking() {
@@ -151,89 +247,99 @@ void App::createInterference() {
     m_pComputeFluid->updateInterferenceInput(interferenceImage);
     m_pGraphicsScene->updateInterferenceInput(interferenceImage);
     m_pComputeMarking->setupInput(interferenceImage, m_pGraphicsScene->getMarkBuffer());
+    if (!m_pGUI) return;
     m_pGUI->addMarkedImage(m_pComputeMarking->getOutputImage());
     m_pGUI->addInterferenceImage(interferenceImage);
 }
 
+void App::createIBLBaker() {
+    LOG("App::createIBLBaker");
+    m_pIBLBaker = new IBLBaker();
+    m_pIBLBaker->setup(1024, {1024, 1024});
+    m_cleaner.push([=](){ m_pIBLBaker->cleanup(); });
+}
+
 void App::createCubemap() {
-    LOG("App::createGraphicsEquirect");
+    LOG("App::createCubemap");
     Files *pFiles = System::Files();
     pFiles->setCubemapIdx(System::Settings()->Cubemaps);
-    Image *hdrImg, *hdrEnv, *cubemap, *envMap, *reflMap, *brdfMap;
-    ComputeHDR* pComputeHDR = new ComputeHDR();
-    pComputeHDR->setupShader();
-    pComputeHDR->createDescriptor();
-    pComputeHDR->createPipelineLayout();
-    pComputeHDR->createPipeline();
-    
-    pComputeHDR->setupInputOutput(pFiles->getCubemapHDRPath());
-    hdrImg = pComputeHDR->dispatch();
-    
-    pComputeHDR->cleanInputOutput();
-    pComputeHDR->setupInputOutput(pFiles->getCubemapEnvPath());
-    hdrEnv = pComputeHDR->dispatch();
-    pComputeHDR->cleanup();
-    
-    uint length = 1024;
-    GraphicsEquirect* pGraphicsEquirect = new GraphicsEquirect();
-    pGraphicsEquirect->setupShader();
-    pGraphicsEquirect->createDescriptor();
-    pGraphicsEquirect->setupMesh();
-    pGraphicsEquirect->createRenderpass();
-    pGraphicsEquirect->createPipelineLayout();
-    pGraphicsEquirect->createPipeline();
-    
-    pGraphicsEquirect->setupInput(hdrImg);
-    pGraphicsEquirect->createFrame(length);
-    cubemap = pGraphicsEquirect->render();
-    m_cleaner.push([=](){ cubemap->cleanup(); });
-    
-    pGraphicsEquirect->cleanFrame();
-    pGraphicsEquirect->setupInput(hdrEnv);
-    pGraphicsEquirect->createFrame(length / 16);
-    envMap = pGraphicsEquirect->render();
-    m_cleaner.push([=](){ envMap->cleanup(); });
-    
-    pGraphicsEquirect->cleanup();
-    hdrImg->cleanup();
-    hdrEnv->cleanup();
-    
-    GraphicsReflection* pGraphicsReflection = new GraphicsReflection();
-    pGraphicsReflection->setupShader();
-    pGraphicsReflection->createDescriptor();
-    pGraphicsReflection->setupMesh();
-    pGraphicsReflection->createRenderpass();
-    pGraphicsReflection->createPipelineLayout();
-    pGraphicsReflection->createPipeline();
-    
-    pGraphicsReflection->setupInput(cubemap);
-    pGraphicsReflection->createFrame();
-    reflMap = pGraphicsReflection->render();
-    m_cleaner.push([=](){ reflMap->cleanup(); });
-    pGraphicsReflection->cleanup();
-    
-    ComputeBRDF* pComputeBRDF = new ComputeBRDF();
-    pComputeBRDF->setupShader();
-    pComputeBRDF->createDescriptor();
-    pComputeBRDF->createPipelineLayout();
-    pComputeBRDF->createPipeline();
-    brdfMap = pComputeBRDF->dispatch({1024, 1024});
-    m_cleaner.push([=](){ brdfMap->cleanup(); });
-    pComputeBRDF->cleanup();
-    
-    m_pGraphicsScene->updateCubemap(cubemap, envMap, reflMap, brdfMap);
+    bakeCubemap(pFiles->getCubemapHDRPath());
+    swapCubemap();
+    m_cleaner.push([=](){ m_activeEnv.cleanup(); });
+}
+
+// Runs on whichever thread calls it, recording on that thread's commander.
+// Only touches m_bakedEnv, which the main thread leaves alone until m_bakeReady.
+void App::bakeCubemap(STRING hdrPath) {
+    LOG("App::bakeCubemap");
+    IBLBaker*    pIBLBaker = m_pIBLBaker;
+    Environment* pBaked    = &m_bakedEnv;
+    pIBLBaker->bake(hdrPath, &pBaked->irradiance);
+    pBaked->cubemap = pIBLBaker->getCubemap();
+    pBaked->reflMap = pIBLBaker->getReflectionMap();
+}
+
+// The replaced environment may still be sampled by frames in flight, it is
+// released once they complete.
+void App::swapCubemap() {
+    LOG("App::swapCubemap");
+    Environment retiredEnv = m_activeEnv;
+    m_pDeletionQueue->retire([=]() mutable { retiredEnv.cleanup(); });
+    m_activeEnv  = m_bakedEnv;
+    m_bakedEnv   = Environment();
+    m_pGraphicsScene->updateCubemap(m_activeEnv.cubemap, &m_activeEnv.irradiance,
+                                    m_activeEnv.reflMap, m_pIBLBaker->getBRDFMap());
+}
+
+void App::checkCubemap() {
+    Settings* settings = System::Settings();
+    if (m_baking && m_bakeReady) {
+        m_bakeThread.join();
+        m_baking    = false;
+        m_bakeReady = false;
+        HitchRecorder::mark("cubemap swap");
+        swapCubemap();
+    }
+    if (settings->BtnUpdateCubemap && !m_baking) {
+        settings->BtnUpdateCubemap = false;
+        STRING hdrPath = System::Files()->getCubemapHDRPath();
+        Commander* pBakeCommander = m_pBakeCommander;
+        m_baking = true;
+        HitchRecorder::mark("bake start");
+        m_bakeThread = std::thread([=](){
+            Tracer::setThreadName("bake");
+            System::setThreadCommander(pBakeCommander);
+            bakeCubemap(hdrPath);
+            HitchRecorder::mark("bake done");
+            System::setThreadCommander(nullptr);
+            m_bakeReady = true;
+        });
+    }
+}
+
+void App::Environment::cleanup() {
+    if (cubemap) cubemap->cleanup();
+    if (reflMap) reflMap->cleanup();
+    cubemap = nullptr;
+    reflMap = nullptr;
 }
 
 void App::setup() {
     System::Instance().initFiles();
+    if (m_pBenchmark) m_pBenchmark->applySettings();
     
     m_pCamera = new Camera();
-    initWindow();
+    if (!m_headless) initWindow();
     initDevice();
     initCommander();
+    initDeletionQueue();
     createGraphicsScreen();
     createSwapchain();
-    createGUI();
+    createAsyncCompute();
+    if (!m_headless) createGUI();
+    createProfilers();
+    createRenderGraphs();
+    createRecorder();
     
     createGraphicsScene();
     createComputeFluid();
@@ -241,6 +347,7 @@ void App::setup() {
     createComputeRain();
     
     createInterference();
+    createIBLBaker();
     createCubemap();
     
 }
@@ -252,36 +359,96 @@ void App::draw() {
     GraphicsScreen* pGraphicsScreen = m_pGraphicsScreen;
     ComputeMarking* pComputeMarking = m_pComputeMarking;
     ComputeRain* pComputeRain = m_pComputeRain;
+    AsyncCompute* pAsyncCompute = m_pAsyncCompute;
+    RenderGraph* pComputeGraph = m_pComputeGraph;
+    RenderGraph* pFrameGraph = m_pFrameGraph;
+    Recorder* pRecorder = m_pRecorder;
+    GPUProfiler* pFrameProfiler   = m_pFrameProfiler;
     GUI* pGUI = m_pGUI;
     
     pSwapchain->prepareFrame();
+    m_pDevice->resetBarrierCount();
+    m_pDevice->updateMemoryBudget();
+    m_pDeletionQueue->collect();
+    m_pFrameProfiler->beginFrame(pSwapchain->getFrameIdx());
     Frame*      pCurrentFrame = pSwapchain->getCurrentFrame();
     VkCommandBuffer cmdBuffer = pSwapchain->getCommandBuffer();
-    
-    VkCommandBufferBeginInfo commandBeginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-    VkResult result = vkBeginCommandBuffer(cmdBuffer, &commandBeginInfo);
-    CHECK_VKRESULT(result, "failed to begin recording command buffer!");
-    
-    if (System::Settings()->RunFluid && System::Settings()->UseHeightmap) {
-        pComputeFluid->dispatch(cmdBuffer);
+    {
+        TRACE_SCOPE("update uniforms");
+        pGraphicsScene->setFrameIdx(pSwapchain->getFrameIdx());
     }
-    if (System::Settings()->RunRain) {
-        pComputeRain->dispatch(cmdBuffer);
+    pRecorder->beginFrame(pSwapchain->getFrameIdx());
+    
+    // This frame renders the slot simulated last frame, while the compute
+    // queue fills the other slot for the next one
+    uint     simulationSlot  = pAsyncCompute->getReadySlot();
+    uint64_t simulationValue = pAsyncCompute->getReadyValue();
+    pGraphicsScene->setSimulationSlot(simulationSlot);
+    if (pGUI) pGUI->setSimulationSlot(simulationSlot);
+    
+    // Settings only change here, before any worker reads them
+    if (pGUI) pGUI->buildGUI();
+    
+    bool runFluid = System::Settings()->RunFluid && System::Settings()->UseHeightmap;
+    bool runRain  = System::Settings()->RunRain;
+    pComputeFluid->setSlot(pAsyncCompute->getNextSlot());
+    pComputeGraph->reset();
+    pComputeFluid->addPasses(pComputeGraph, runFluid);
+    pComputeRain->addPass(pComputeGraph, runRain);
+    pComputeGraph->compile();
+    bool runCompute = pComputeGraph->hasWork();
+    uint computeJob = 0;
+    if (runCompute) computeJob = pRecorder->run([=](){ recordCompute(); });
+    pGraphicsScreen->setFrame(pCurrentFrame, pSwapchain->getFrameIdx());
+    
+    pFrameGraph->reset();
+    pGraphicsScene->addPasses(pFrameGraph);
+    pComputeMarking->addPass(pFrameGraph);
+    uint screenPass = pGraphicsScreen->addPass(pFrameGraph);
+    pFrameGraph->readImage(screenPass, pComputeMarking->getOutputImage(), VK_IMAGE_LAYOUT_GENERAL,
+                           VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    pFrameGraph->compile();
+    pGraphicsScene->recordAsync(pRecorder);
+    pGraphicsScreen->recordAsync(pRecorder, pGUI, pFrameProfiler);
+    
+    {
+        TRACE_SCOPE("record primary");
+        VkCommandBufferBeginInfo commandBeginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        VkResult result = vkBeginCommandBuffer(cmdBuffer, &commandBeginInfo);
+        CHECK_VKRESULT(result, "failed to begin recording command buffer!");
+        
+        pFrameProfiler->cmdReset(cmdBuffer);
+        pFrameGraph->execute(cmdBuffer);
+        
+        vkEndCommandBuffer(cmdBuffer);
     }
     
-    pGraphicsScene->render(cmdBuffer);
-    
-    pComputeMarking->dispatch(cmdBuffer);
-    
-    pGraphicsScreen->setFrame(pCurrentFrame);
-    pGraphicsScreen->render(cmdBuffer, pGUI);
-    
-    vkEndCommandBuffer(cmdBuffer);
+    if (runCompute) {
+        pRecorder->wait(computeJob);
+        pAsyncCompute->submit(pSwapchain->getTimeline());
+        if (pComputeGraph->isLive("fluid")) pAsyncCompute->publish();
+    }
+    pRecorder->waitAll();
     
-    pSwapchain->submitFrame();
+    pSwapchain->submitFrame(pAsyncCompute->getTimeline(), simulationValue,
+                            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    pAsyncCompute->setReadValue(simulationSlot, pSwapchain->getSubmitValue());
     pSwapchain->presentFrame();
 }
 
+// Runs on a recorder worker. Only captures the app, so the job's function
+// is stored without a heap allocation.
+void App::recordCompute() {
+    AsyncCompute* pAsyncCompute    = m_pAsyncCompute;
+    RenderGraph*  pComputeGraph    = m_pComputeGraph;
+    GPUProfiler*  pComputeProfiler = m_pComputeProfiler;
+    
+    VkCommandBuffer computeBuffer = pAsyncCompute->begin();
+    pComputeProfiler->beginFrame(pAsyncCompute->getFrameIdx());
+    pComputeProfiler->cmdReset(computeBuffer);
+    pComputeGraph->execute(computeBuffer);
+}
+
 void App::update() {
     Settings* settings = System::Settings();
     Window*   pWindow  = m_pWindow;
@@ -290,12 +457,22 @@ void App::update() {
         if (settings->LockFocus) moveViewLock(pWindow);
         else                     moveView(pWindow);
     }
-    if (settings->BtnUpdateCubemap) {
-        settings->BtnUpdateCubemap = false;
-        createCubemap();
+    checkCubemap();
+    if (settings->BtnExportTrace) {
+        settings->BtnExportTrace = false;
+        Tracer::exportChromeTrace("trace.json");
+    }
+    if (settings->BtnStallReport) {
+        settings->BtnStallReport = false;
+        StallAuditor::report("on demand");
+    }
+    if (settings->BtnExportMemory) {
+        settings->BtnExportMemory = false;
+        m_pDevice->exportMemoryJSON("memory.json");
     }
     if (settings->BtnUpdateTexture) {
         settings->BtnUpdateTexture = false;
+        HitchRecorder::mark("texture reload");
         m_pGraphicsScene->updateTexture();
     }
     
@@ -369,29 +546,83 @@ void App::loop() {
     LOG("App::loop");
     RenderTime* pRenderTime = System::RenderTime();
     Settings  * pSettings   = System::Settings();
+    Tracer::setThreadName("main");
     
     while (m_pWindow->isOpen()) {
+        TRACE_SCOPE("frame");
+        TimeVal frameStart = ChronoTime::now();
+        AllocTracker::beginFrame();
         bool lockFps = System::Settings()->LockFPS;
         
         pSettings->Iteration++;
-        m_pWindow->pollEvents();
+        {
+            TRACE_SCOPE("poll events");
+            m_pWindow->pollEvents();
+        }
         checkResized();
-        update();
+        {
+            TRACE_SCOPE("update");
+            update();
+        }
         m_pWindow->resetInput();
         
         pRenderTime->startRender();
         while (pRenderTime->checkLag()) {
-            draw();
+            {
+                TRACE_SCOPE("draw");
+                draw();
+            }
             pRenderTime->addRenderTime();
+            TRACE_SCOPE("sleep");
             pRenderTime->sleepIf(lockFps);
         }
+        StallAuditor::endFrame();
+        AllocTracker::endFrame();
+        HitchRecorder::endFrame(frameStart, ChronoTime::now(), pSettings->HitchThreshold);
+    }
+    if (m_baking) m_bakeThread.join();
+    m_pDevice->waitIdle();
+}
+
+// Renders the benchmark's frames with no input. What a frame shows only
+// depends on its index: the camera path, the light motion and the one
+// simulation step every frame takes.
+void App::loopHeadless() {
+    LOG("App::loopHeadless");
+    Benchmark* pBenchmark = m_pBenchmark;
+    Settings*  pSettings  = System::Settings();
+    uint       frameCount = pBenchmark->getFrameCount();
+    Tracer::setThreadName("main");
+    
+    for (uint i = 0; i < frameCount; i++) {
+        TRACE_SCOPE("frame");
+        TimeVal frameStart = ChronoTime::now();
+        pSettings->Iteration = i;
+        pBenchmark->placeCamera(m_pCamera, i);
+        m_pGraphicsScene->updateLightInput();
+        m_pGraphicsScene->updateParamInput();
+        m_pGraphicsScene->updateCameraInput(m_pCamera);
+        
+        pBenchmark->beginFrame(i);
+        AllocTracker::beginFrame();
+        {
+            TRACE_SCOPE("draw");
+            draw();
+        }
+        StallAuditor::endFrame();
+        AllocTracker::endFrame();
+        pBenchmark->endFrame();
+        HitchRecorder::endFrame(frameStart, ChronoTime::now(), pSettings->HitchThreshold);
     }
     m_pDevice->waitIdle();
+    pBenchmark->finish();
+    StallAuditor::report("benchmark");
 }
 
 void App::checkResized() {
     if (!m_pWindow->checkResized()) return;
     LOG("App::resized");
+    HitchRecorder::mark("resize");
     UInt2D size = m_pWindow->getFrameSize();
     
     m_pSwapchain->recreate();
@@ -7,35 +7,57 @@
 #include "window/gui.hpp"
 #include "renderer/device.hpp"
 #include "renderer/commander.hpp"
+#include "renderer/deletion_queue.hpp"
 #include "renderer/swapchain.hpp"
+#include "renderer/async_compute.hpp"
+#include "renderer/render_graph.hpp"
+#include "renderer/recorder.hpp"
+#include "renderer/gpu_profiler.hpp"
 #include "pipelines/graphics_screen.hpp"
-#include "pipelines/compute_hdr.hpp"
-#include "pipelines/compute_brdf.hpp"
 #include "pipelines/compute_interference.hpp"
 #include "pipelines/compute_fluid.hpp"
 #include "pipelines/compute_marking.hpp"
 #include "pipelines/compute_rain.hpp"
-#include "pipelines/graphics_reflection.hpp"
 #include "pipelines/graphics_scene.hpp"
-#include "pipelines/graphics_equirect.hpp"
+#include "pipelines/ibl_baker.hpp"
 #include "resources/camera.hpp"
 #include "resources/buffer.hpp"
+#include "resources/irradiance.hpp"
+#include "benchmark.hpp"
+
+#include <thread>
+#include <atomic>
 
 class App {
 public:
     
     void run();
+    void setBenchmark(Benchmark* pBenchmark);
 
 private:
     Cleaner m_cleaner;
-    Window* m_pWindow;
+    Window* m_pWindow = nullptr;
     Device* m_pDevice;
     Commander* m_pCommander;
+    Commander* m_pBakeCommander;
+    DeletionQueue* m_pDeletionQueue;
     
     Camera* m_pCamera;
-    GUI*    m_pGUI;
+    GUI*    m_pGUI = nullptr;
+    
+    // Benchmarks run headless, rendering offscreen with no window, GUI or input
+    Benchmark* m_pBenchmark = nullptr;
+    bool       m_headless   = false;
+    UInt2D     m_headlessSize = {};
     
     Swapchain* m_pSwapchain;
+    AsyncCompute* m_pAsyncCompute;
+    RenderGraph* m_pComputeGraph;
+    RenderGraph* m_pFrameGraph;
+    Recorder* m_pRecorder;
+    GPUProfiler* m_pFrameProfiler;
+    GPUProfiler* m_pComputeProfiler;
+    GPUProfiler* m_pBakeProfiler;
     GraphicsScreen* m_pGraphicsScreen;
     GraphicsScene* m_pGraphicsScene;
     
@@ -43,17 +65,38 @@ private:
     ComputeMarking* m_pComputeMarking;
     ComputeRain* m_pComputeRain;
     
+    struct Environment {
+        Image* cubemap = nullptr;
+        Image* reflMap = nullptr;
+        Irradiance irradiance;
+        
+        void cleanup();
+    };
+    IBLBaker* m_pIBLBaker;
+    Environment m_activeEnv;
+    Environment m_bakedEnv;
+    std::thread       m_bakeThread;
+    std::atomic<bool> m_bakeReady{false};
+    bool              m_baking = false;
+    
     void cleanup();
     void setup();
     void loop();
+    void loopHeadless();
     void update();
     void draw();
+    void recordCompute();
     
     void initWindow();
     void initDevice();
     void initCommander();
+    void initDeletionQueue();
     
     void createSwapchain();
+    void createAsyncCompute();
+    void createProfilers();
+    void createRenderGraphs();
+    void createRecorder();
     void createGraphicsScreen();
     void createInterference();
     void createComputeFluid();
@@ -62,7 +105,11 @@ private:
     void dispatchInterference();
     void createGraphicsScene();
     
+    void createIBLBaker();
     void createCubemap();
+    void bakeCubemap(STRING hdrPath);
+    void swapCubemap();
+    void checkCubemap();
     
     void createGUI();
     
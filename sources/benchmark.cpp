@@ -0,0 +1,254 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "benchmark.hpp"
+
+#include "system.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+Benchmark::~Benchmark() {}
+Benchmark::Benchmark() {}
+
+void Benchmark::setup(Scenario scenario) {
+    LOG("Benchmark::setup " + scenario.name);
+    m_scenario = scenario;
+}
+
+void Benchmark::setOutput(STRING path) { m_outputPath = path; }
+
+void Benchmark::setBaseline(STRING path, float threshold) {
+    m_baselinePath = path;
+    m_threshold    = threshold;
+}
+
+void Benchmark::addProfiler(GPUProfiler* pProfiler) { m_pProfilers.push_back(pProfiler); }
+
+// Before the app creates its resources, so textures and the cubemap load once
+void Benchmark::applySettings() {
+    Settings* settings = System::Settings();
+    Scenario  scenario = m_scenario;
+    settings->Shapes     = scenario.shape;
+    settings->UseTexture = scenario.texture >= 0;
+    settings->Textures   = std::max(scenario.texture, 0);
+    settings->Cubemaps   = scenario.cubemap;
+    settings->RunFluid   = scenario.fluid;
+    settings->TotalLight = scenario.lights;
+    settings->LightMove  = true;
+    settings->Iteration  = 0;
+    if (scenario.fluid) settings->UseHeightmap = true;
+    System::Files()->setTextureIdx(settings->Textures);
+    
+    // Rain drops are seeded from rand()
+    srand(0);
+}
+
+void Benchmark::placeCamera(Camera* pCamera, uint frame) {
+    CameraPath path     = m_scenario.camera;
+    float      progress = FLOAT(frame) / getFrameCount();
+    float      angle    = 2.f * M_PI * path.turns * progress;
+    float      distance = path.startDistance + (path.endDistance - path.startDistance) * progress;
+    pCamera->setPosition({distance * sin(angle), path.height, distance * cos(angle)});
+    pCamera->lookAt({0.f, 0.f, 0.f});
+}
+
+// GPU samples taken before the first frame, e.g. the setup bakes, are skipped
+void Benchmark::beginFrame(uint frame) {
+    if (frame == 0) sampleProfilers(false);
+    m_frame      = frame;
+    m_frameStart = ChronoTime::now();
+}
+
+// CPU phases are the tracer scopes that ran during the frame, on any thread.
+// Stalls are the GPU waits and submits of the frame the auditor just closed.
+void Benchmark::endFrame() {
+    bool  measured  = m_frame >= m_scenario.warmup;
+    float frameTime = TimeDif(ChronoTime::now() - m_frameStart).count() * 1000.f;
+    std::map<STRING, float> phases = Tracer::sumSince(m_frameStart);
+    StallAuditor::FrameStats stalls = StallAuditor::getLastFrame();
+    sampleProfilers(measured);
+    if (!measured) return;
+    
+    addSample("cpu.frame", frameTime);
+    for (auto& phase : phases) addSample("cpu." + phase.first, phase.second);
+    addSample("stall.wait",   stalls.kinds[StallAuditor::Wait].ms);
+    addSample("stall.submit", stalls.kinds[StallAuditor::Submit].ms);
+}
+
+// The device must be idle, the last frames' GPU results are read back here
+void Benchmark::finish() {
+    LOG("Benchmark::finish");
+    for (GPUProfiler* pProfiler : m_pProfilers) pProfiler->collectAll();
+    sampleProfilers(true);
+    
+    std::map<STRING, float> metrics = summarize();
+    for (auto& metric : metrics)
+        if (HasSuffix(metric.first, ".avg")) LOG(metric.first << " " << metric.second << " ms");
+    
+    if (!m_outputPath.empty())   writeJSON(metrics);
+    if (!m_baselinePath.empty()) m_passed = compareBaseline(metrics);
+}
+
+Benchmark::Scenario Benchmark::getScenario() { return m_scenario; }
+uint Benchmark::getFrameCount() { return m_scenario.warmup + m_scenario.frames; }
+bool Benchmark::hasPassed()     { return m_passed; }
+
+bool Benchmark::FindScenario(STRING name, Scenario* pScenario) {
+    for (Scenario& scenario : Scenarios()) {
+        if (scenario.name != name) continue;
+        *pScenario = scenario;
+        return true;
+    }
+    ERR("unknown benchmark scenario " + name);
+    return false;
+}
+
+// The scene as the app opens it, one orbit at the default distance
+Benchmark::Scenario Benchmark::DefaultScenario() { return Scenarios()[0]; }
+
+// Private ==================================================
+
+void Benchmark::addSample(STRING name, float value) {
+    VECTOR<float>& samples = m_samples[name];
+    if (samples.empty()) m_names.push_back(name);
+    samples.push_back(value);
+}
+
+// Profiler results arrive frames late, only the samples added since the last
+// call are taken. Totals are tracked during the warmup too.
+void Benchmark::sampleProfilers(bool measured) {
+    for (GPUProfiler* pProfiler : m_pProfilers) {
+        for (GPUProfiler::ScopeStats& stats : pProfiler->getStats()) {
+            STRING   name  = "gpu." + pProfiler->getName() + "." + stats.name;
+            uint64_t added = std::min<uint64_t>(stats.total - m_gpuTotals[name], stats.history.size());
+            m_gpuTotals[name] = stats.total;
+            if (!measured) continue;
+            for (size_t i = stats.history.size() - added; i < stats.history.size(); i++)
+                addSample(name, stats.history[i]);
+        }
+    }
+}
+
+std::map<STRING, float> Benchmark::summarize() {
+    std::map<STRING, float> metrics;
+    for (STRING& name : m_names) {
+        VECTOR<float> sorted = m_samples[name];
+        std::sort(sorted.begin(), sorted.end());
+        float total = 0.f;
+        for (float sample : sorted) total += sample;
+        metrics[name + ".avg"] = total / sorted.size();
+        metrics[name + ".min"] = sorted.front();
+        metrics[name + ".p99"] = sorted[(sorted.size() * 99 + 99) / 100 - 1];
+        metrics[name + ".max"] = sorted.back();
+    }
+    
+    Device* pDevice = System::Device();
+    metrics["memory.allocated_mb"] = pDevice->getAllocatedMemory() / (1024.f * 1024.f);
+    metrics["memory.peak_mb"]      = pDevice->getPeakMemory()      / (1024.f * 1024.f);
+    metrics["memory.allocations"]  = pDevice->getAllocationCount();
+    for (uint i = 0; i < MEMORY_TAG_COUNT; i++) {
+        MemoryTag tag = MemoryTag(i);
+        metrics["memory." + STRING(Device::MemoryTagName(tag)) + "_mb"] = pDevice->getTaggedMemory(tag) / (1024.f * 1024.f);
+    }
+    
+    // The driver's usage includes other processes, it is recorded but not compared
+    pDevice->updateMemoryBudget();
+    const VECTOR<Device::HeapBudget>& heaps = pDevice->getHeapBudgets();
+    for (uint i = 0; i < heaps.size(); i++) {
+        STRING heap = "heap" + std::to_string(i);
+        metrics[heap + ".usage_mb"]  = heaps[i].usage  / (1024.f * 1024.f);
+        metrics[heap + ".budget_mb"] = heaps[i].budget / (1024.f * 1024.f);
+    }
+    return metrics;
+}
+
+// One metric per line, which is all ReadMetrics() expects of a baseline
+void Benchmark::writeJSON(const std::map<STRING, float>& metrics) {
+    LOG("Benchmark::writeJSON " + m_outputPath);
+    Scenario      scenario = m_scenario;
+    std::ofstream file(m_outputPath);
+    if (!file.is_open()) {
+        ERR("failed to open benchmark output " + m_outputPath);
+        return;
+    }
+    
+    file << std::fixed << std::setprecision(4);
+    file << "{\n";
+    file << "  \"scenario\": \"" << scenario.name << "\",\n";
+    file << "  \"device\": \"" << System::Device()->getDeviceName() << "\",\n";
+    file << "  \"width\": " << scenario.size.width << ",\n";
+    file << "  \"height\": " << scenario.size.height << ",\n";
+    file << "  \"warmup\": " << scenario.warmup << ",\n";
+    file << "  \"frames\": " << scenario.frames << ",\n";
+    file << "  \"metrics\": {\n";
+    uint idx = 0;
+    for (auto& metric : metrics) {
+        file << "    \"" << metric.first << "\": " << metric.second
+             << (++idx < metrics.size() ? ",\n" : "\n");
+    }
+    file << "  }\n";
+    file << "}\n";
+}
+
+// Averages, 99th percentiles and memory may grow by at most the threshold.
+// Metrics missing on either side are not compared.
+bool Benchmark::compareBaseline(const std::map<STRING, float>& metrics) {
+    LOG("Benchmark::compareBaseline " + m_baselinePath);
+    std::map<STRING, float> baseline = ReadMetrics(m_baselinePath);
+    if (baseline.empty()) {
+        ERR("no metrics in benchmark baseline " + m_baselinePath);
+        return false;
+    }
+    
+    uint regressions = 0;
+    for (auto& metric : metrics) {
+        const STRING& name = metric.first;
+        bool timing = HasSuffix(name, ".avg") || HasSuffix(name, ".p99");
+        bool memory = name.compare(0, 7, "memory.") == 0;
+        if ((!timing && !memory) || !baseline.count(name)) continue;
+    
+        float base  = baseline[name];
+        float delta = metric.second - base;
+        if (timing && delta < BENCHMARK_MIN_DELTA) continue;
+        if (delta <= base * m_threshold) continue;
+        ERR("regression " << name << " " << base << " -> " << metric.second);
+        regressions++;
+    }
+    LOG("Benchmark " << regressions << " regressions over " << m_threshold * 100.f << "%");
+    return regressions == 0;
+}
+
+// Scenarios are listed by name, the first one is the default
+VECTOR<Benchmark::Scenario> Benchmark::Scenarios() {
+    return {
+        { "default",  0, -1, 1, false, 4, {1200,  800}, 30, 600, {1.f, 3.f, 3.f,  0.f} },
+        { "bubble",   0, -1, 1, true,  0, {1200,  800}, 30, 600, {1.f, 3.f, 3.f,  .5f} },
+        { "steel",    1, -1, 2, false, 2, {1200,  800}, 30, 600, {.5f, 4.f, 2.5f, 1.f} },
+        { "textured", 2,  3, 4, false, 4, {1200,  800}, 30, 600, {1.f, 2.5f, 5.f, 1.f} },
+        { "fluid-4k", 0, -1, 1, true,  4, {3840, 2160}, 30, 300, {1.f, 3.f, 3.f,  .5f} },
+    };
+}
+
+// Reads the metrics object of a file written by writeJSON()
+std::map<STRING, float> Benchmark::ReadMetrics(STRING path) {
+    std::map<STRING, float> metrics;
+    std::ifstream file(path);
+    STRING line;
+    bool   inMetrics = false;
+    while (std::getline(file, line)) {
+        if (line.find("\"metrics\"") != STRING::npos) { inMetrics = true; continue; }
+        size_t open  = line.find('"');
+        size_t close = line.find('"', open + 1);
+        size_t colon = line.find(':', close);
+        if (!inMetrics || open == STRING::npos || close == STRING::npos || colon == STRING::npos) continue;
+        metrics[line.substr(open + 1, close - open - 1)] = std::stof(line.substr(colon + 1));
+    }
+    return metrics;
+}
+
+bool Benchmark::HasSuffix(const STRING& name, const STRING& suffix) {
+    return name.size() >= suffix.size() &&
+           name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
@@ -0,0 +1,88 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "include.h"
+#include "renderer/gpu_profiler.hpp"
+#include "resources/camera.hpp"
+
+#define BENCHMARK_THRESHOLD 0.1f  // Relative growth reported as a regression
+#define BENCHMARK_MIN_DELTA 0.05f // ms, timing changes below are noise
+
+// Fixed length headless runs of a named scenario. The settings, the camera
+// and the simulation step only depend on the frame index, so two runs render
+// the same frames. Per-phase CPU times, per-pass GPU times and device memory
+// are written as JSON and checked against the results of an earlier run.
+class Benchmark {
+
+public:
+    // Orbits the origin while moving from the start to the end distance
+    struct CameraPath {
+        float turns;
+        float startDistance;
+        float endDistance;
+        float height;
+    };
+    
+    struct Scenario {
+        STRING     name;
+        int        shape;
+        int        texture; // -1 for the plain material
+        int        cubemap;
+        bool       fluid;
+        int        lights;
+        UInt2D     size;
+        uint       warmup;  // Rendered before measuring, e.g. first pipeline use
+        uint       frames;
+        CameraPath camera;
+    };
+    
+    ~Benchmark();
+    Benchmark();
+    
+    void setup(Scenario scenario);
+    void setOutput(STRING path);
+    void setBaseline(STRING path, float threshold);
+    void addProfiler(GPUProfiler* pProfiler);
+    
+    void applySettings();
+    void placeCamera(Camera* pCamera, uint frame);
+    void beginFrame(uint frame);
+    void endFrame();
+    void finish();
+    
+    Scenario getScenario();
+    uint     getFrameCount();
+    bool     hasPassed();
+    
+    static bool     FindScenario(STRING name, Scenario* pScenario);
+    static Scenario DefaultScenario();
+
+private:
+    Scenario m_scenario{};
+    STRING   m_outputPath;
+    STRING   m_baselinePath;
+    float    m_threshold = BENCHMARK_THRESHOLD;
+    bool     m_passed    = true;
+    
+    uint     m_frame = 0;
+    TimeVal  m_frameStart;
+    VECTOR<GPUProfiler*>       m_pProfilers;
+    std::map<STRING, uint64_t> m_gpuTotals;
+    
+    // Samples in ms, metrics in the order they were first seen
+    VECTOR<STRING> m_names;
+    std::map<STRING, VECTOR<float>> m_samples;
+    
+    void addSample(STRING name, float value);
+    void sampleProfilers(bool measured);
+    std::map<STRING, float> summarize();
+    void writeJSON(const std::map<STRING, float>& metrics);
+    bool compareBaseline(const std::map<STRING, float>& metrics);
+    
+    static VECTOR<Scenario> Scenarios();
+    static std::map<STRING, float> ReadMetrics(STRING path);
+    static bool HasSuffix(const STRING& name, const STRING& suffix);
+
+};
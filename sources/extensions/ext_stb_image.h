@@ -2,7 +2,6 @@
 //
 
 #pragma once
-#define STB_IMAGE_IMPLEMENTATION
 
 #include "../libraries/stb_image/stb_image.h"
 #include "include.h"
@@ -44,7 +44,6 @@ void Files::setCubemapIdx(uint idx) { m_cubemapIdx = idx; }
 uint Files::getTotalCubemap() { return UINT32(CUBEMAP_NAMES.size()); }
 STRING Files::getCubemapName() { return CUBEMAP_NAMES[m_cubemapIdx] + "/" + CUBEMAP_NAMES[m_cubemapIdx]; }
 STRING Files::getCubemapHDRPath() { return CUBE_PATH + getCubemapName() + CUBEMAP_HDR_PATH; }
-STRING Files::getCubemapEnvPath() { return CUBE_PATH + getCubemapName() + CUBEMAP_ENV_PATH; }
 
 uint Files::getTotalTexture() { return UINT32(TEXTURE_NAMES.size()); }
 STRING Files::getTextureName() { return TEXTURE_NAMES[m_textureIdx] + "/" + TEXTURE_NAMES[m_textureIdx]; }
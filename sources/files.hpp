@@ -39,7 +39,6 @@ public:
     uint   getTotalCubemap();
     STRING getCubemapName();
     STRING getCubemapHDRPath();
-    STRING getCubemapEnvPath();
     VECTOR<Image*> getCubemapPreviews();
     
 private:
@@ -47,7 +46,6 @@ private:
     
     const VECTOR<STRING> CUBEMAP_NAMES = {"Arches_E_PineTree", "GravelPlaza", "Tokyo_BigSight", "ArboretumInBloom", "Hamarikyu_Bridge_B", "hdrvfx_0011_zanla", "Tropical_Beach", "Ueno-Shrine"};
     const STRING CUBEMAP_HDR_PATH = ".hdr";
-    const STRING CUBEMAP_ENV_PATH = "_Env.hdr";
     const STRING CUBEMAP_PREV_PATH = "_Preview.jpg";
     
     const VECTOR<STRING> TEXTURE_NAMES = { "worn-wet-old-cobblestone", "cobblestylized", "greasypan", "layered-rock1", "rustediron", "slipperystonework", "roughrockface", "slimy-slippery-rock1", "cliffrockface", "limestone6"};
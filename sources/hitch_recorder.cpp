@@ -0,0 +1,110 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "hitch_recorder.hpp"
+
+#include "tracer.hpp"
+#include "renderer/gpu_profiler.hpp"
+
+#include <fstream>
+#include <iomanip>
+
+// Registered during setup, before the first frame
+void HitchRecorder::addProfiler(GPUProfiler* pProfiler) {
+    GetState().pProfilers.push_back(pProfiler);
+}
+
+// Callable from any thread. The name must outlive the recorder, string
+// literals are expected.
+void HitchRecorder::mark(const char* name) {
+    State&   state = GetState();
+    uint64_t index = state.markCount.fetch_add(1, std::memory_order_relaxed);
+    Mark&    mark  = state.marks[index % HITCH_MARK_RING];
+    mark.time.store(Tracer::toTraceTime(ChronoTime::now()), std::memory_order_relaxed);
+    mark.name.store(name, std::memory_order_release);
+}
+
+// Called once per frame by the frame loop. Costs two stores and a compare
+// unless the frame is a hitch. A threshold of zero records without dumping.
+void HitchRecorder::endFrame(TimeVal start, TimeVal end, float thresholdMs) {
+    State& state = GetState();
+    Frame  frame = {Tracer::toTraceTime(start), Tracer::toTraceTime(end) - Tracer::toTraceTime(start)};
+    state.frames[state.frameCount % HITCH_FRAME_RING] = frame;
+    state.frameCount++;
+    
+    if (state.frameCount <= HITCH_WARMUP || thresholdMs <= 0.f) return;
+    if (frame.duration < int64_t(thresholdMs * 1e6f)) return;
+    if (state.dumpCount > 0 && frame.start - state.lastDump < int64_t(HITCH_WINDOW * 1e9f)) return;
+    state.lastDump = frame.start;
+    state.dumpCount++;
+    Dump(frame, thresholdMs);
+}
+
+uint HitchRecorder::getDumpCount() { return GetState().dumpCount; }
+
+// Private ==================================================
+
+HitchRecorder::State& HitchRecorder::GetState() {
+    static State state;
+    return state;
+}
+
+// Frames and markers share a row of the trace. The GPU histories have no
+// timestamps, results arrive frames late, so they are written beside the
+// events as the last samples of every scope, oldest first.
+void HitchRecorder::Dump(const Frame& hitch, float thresholdMs) {
+    TRACE_SCOPE("hitch dump");
+    State&   state     = GetState();
+    uint64_t frameIdx  = state.frameCount - 1;
+    int64_t  since     = hitch.start - int64_t(HITCH_WINDOW * 1e9f);
+    int64_t  threshold = int64_t(thresholdMs * 1e6f);
+    STRING   path      = "hitch_" + std::to_string(frameIdx) + ".json";
+    
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        ERR("failed to open hitch file " + path);
+        return;
+    }
+    
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    file << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << HITCH_TRACE_TID
+         << ",\"args\":{\"name\":\"frames\"}}";
+    
+    uint64_t begin = state.frameCount > HITCH_FRAME_RING ? state.frameCount - HITCH_FRAME_RING : 0;
+    for (uint64_t i = begin; i < state.frameCount; i++) {
+        const Frame& frame = state.frames[i % HITCH_FRAME_RING];
+        if (frame.start + frame.duration < since) continue;
+        file << ",\n{\"name\":\"" << (frame.duration < threshold ? "frame" : "hitch")
+             << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << HITCH_TRACE_TID
+             << ",\"ts\":" << frame.start / 1000.0 << ",\"dur\":" << frame.duration / 1000.0
+             << ",\"args\":{\"index\":" << i << "}}";
+    }
+    
+    uint64_t markCount = state.markCount.load(std::memory_order_relaxed);
+    uint64_t markBegin = markCount > HITCH_MARK_RING ? markCount - HITCH_MARK_RING : 0;
+    for (uint64_t i = markBegin; i < markCount; i++) {
+        Mark&       mark = state.marks[i % HITCH_MARK_RING];
+        const char* name = mark.name.load(std::memory_order_acquire);
+        int64_t     time = mark.time.load(std::memory_order_relaxed);
+        if (!name || time < since) continue;
+        file << ",\n{\"name\":\"" << name << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":" << HITCH_TRACE_TID
+             << ",\"ts\":" << time / 1000.0 << "}";
+    }
+    
+    Tracer::writeChromeEvents(file, since);
+    
+    file << "\n],\n\"hitch\":{\"frame\":" << frameIdx << ",\"ms\":" << hitch.duration / 1e6
+         << ",\"threshold_ms\":" << thresholdMs << "},\n\"gpuHistory\":{";
+    bool first = true;
+    for (GPUProfiler* pProfiler : state.pProfilers) {
+        for (GPUProfiler::ScopeStats& scope : pProfiler->getStats()) {
+            file << (first ? "" : ",") << "\n\"" << pProfiler->getName() << "." << scope.name << "\":[";
+            for (uint i = 0; i < scope.history.size(); i++)
+                file << (i ? "," : "") << scope.history[i];
+            file << "]";
+            first = false;
+        }
+    }
+    file << "\n}}\n";
+    LOG("HitchRecorder::dumped " + path + " frame " + std::to_string(hitch.duration / 1e6) + " ms");
+}
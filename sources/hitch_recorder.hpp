@@ -0,0 +1,58 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "include.h"
+
+#include <atomic>
+
+#define HITCH_FRAME_RING   2048  // Frames kept, a power of two
+#define HITCH_MARK_RING    64    // Markers kept, a power of two
+#define HITCH_THRESHOLD_MS 50.f  // Default frame time dumped as a hitch
+#define HITCH_WINDOW       3.f   // Seconds of context dumped before a hitch
+#define HITCH_WARMUP       10    // First frames never dumped, setup spikes are expected
+#define HITCH_TRACE_TID    1000  // Row of the frames and markers, past the tracer's threads
+
+class GPUProfiler;
+
+// Always-on flight recorder of the last frames. Frame times and event markers
+// go into fixed rings; a frame longer than the threshold dumps the window
+// before it as a Chrome trace, with the tracer's CPU scopes and the recent GPU
+// timings of the registered profilers. Dumps are at least a window apart, so
+// a burst of slow frames is written once.
+class HitchRecorder {
+
+    struct Frame {
+        int64_t start;    // ns on the tracer clock
+        int64_t duration; // ns
+    };
+    
+    // Atomic fields, a marker may be overwritten while a dump reads it
+    struct Mark {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int64_t>     time{0}; // ns on the tracer clock
+    };
+
+public:
+    static void addProfiler(GPUProfiler* pProfiler);
+    static void mark(const char* name);
+    static void endFrame(TimeVal start, TimeVal end, float thresholdMs);
+    static uint getDumpCount();
+
+private:
+    // Frames are written by the main thread only, markers by any thread
+    struct State {
+        Frame                 frames[HITCH_FRAME_RING];
+        uint64_t              frameCount = 0;
+        Mark                  marks[HITCH_MARK_RING];
+        std::atomic<uint64_t> markCount{0};
+        int64_t               lastDump   = 0;
+        std::atomic<uint>     dumpCount{0};
+        VECTOR<GPUProfiler*>  pProfilers;
+    };
+    
+    static State& GetState();
+    static void Dump(const Frame& hitch, float thresholdMs);
+
+};
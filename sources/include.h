@@ -28,6 +28,8 @@
 
 #pragma clang diagnostic pop
 
+#include "logger.hpp"
+
 #ifdef NDEBUG
 #define IS_DEBUG false
 #else
@@ -50,8 +52,15 @@
 #define MOD_VAR(v) {}
 #define USE_FUNC(f) {}
 
-#define LOG(v) std::cout << "LOG::" << v << std::endl
-#define ERR(v) std::cout << "ERR::" << v << std::endl
+// Lines go through the asynchronous Logger, verbose ones only in debug builds
+#define LOG_LEVEL(l, v) if (!Logger::isEnabled(l)) {} else LogLine(l).stream() << v
+#ifdef NDEBUG
+#define LOGV(v) {}
+#else
+#define LOGV(v) LOG_LEVEL(Logger::Verbose, v)
+#endif
+#define LOG(v)  LOG_LEVEL(Logger::Info,    v)
+#define ERR(v)  LOG_LEVEL(Logger::Error,   v)
 
 #define PRINT1(  v1            ) std::cout << v1
 #define PRINT2(  v1, v2        ) PRINT1(v1        ) << " " << v2
@@ -73,6 +82,8 @@
 #define PI 3.14159265358979323846
 
 #define CHANNEL 4
+#define MAX_FRAMES_IN_FLIGHT 2
+#define SIMULATION_SLOT_COUNT 2
 #define VEC4_BLACK { 0.f, 0.f, 0.f, 0.f }
 #define VEC4_WHITE { 1.f, 1.f, 1.f, 1.f }
 
@@ -91,15 +102,15 @@ struct Cleaner {
     std::stack<std::function<void()>> stack;
 
     void push(std::function<void()>&& function) {
-        stack.push(function);
+        stack.push(std::move(function));
     }
 
     void flush(std::string name = "") {
-        printf ("Clean::%s::%lu process \n", name.c_str(), stack.size());
+        LOGV("Clean::" << name << "::" << stack.size() << " process");
         while (!stack.empty()) {
-            std::function<void()> cleaning = stack.top();
-            cleaning();
+            std::function<void()> cleaning = std::move(stack.top());
             stack.pop();
+            cleaning();
         }
     }
 };
@@ -0,0 +1,156 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "logger.hpp"
+
+#include "include.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#define LOGGER_DRAIN_MS 2 // Sleep of the drain thread when the ring is empty
+
+// Lines are stamped in seconds since the first one
+static TimeVal Epoch() {
+    static TimeVal epoch = ChronoTime::now();
+    return epoch;
+}
+
+// A slot is free for the line numbered as its sequence, and holds that line
+// once the sequence is one past it
+struct Logger::Slot {
+    std::atomic<uint64_t> sequence{0};
+    Level    level  = Info;
+    float    time   = 0.f;
+    uint32_t length = 0;
+    char     text[LOGGER_LINE_SIZE];
+};
+
+struct Logger::Queue {
+    Slot                  slots[LOGGER_RING_SIZE];
+    std::atomic<uint64_t> head{0}; // Next line to reserve
+    std::atomic<uint64_t> tail{0}; // Next line to write
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool>     stopping{false};
+    std::thread           thread;
+    
+    // Lines pushed after this are written directly
+    ~Queue() {
+        Stopped().store(true);
+        stopping.store(true, std::memory_order_release);
+        thread.join();
+    }
+    Queue() {
+        for (uint i = 0; i < LOGGER_RING_SIZE; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+        thread = std::thread([this](){ Drain(*this); });
+    }
+};
+
+// Producers claim a slot by moving the head, then publish it through the
+// slot's sequence, so concurrent pushes take no lock
+void Logger::push(Level level, const char* text, size_t length) {
+    float time = TimeDif(ChronoTime::now() - Epoch()).count();
+    if (Stopped().load()) {
+        Write(level, time, text, length);
+        std::cout.flush();
+        return;
+    }
+    
+    Queue&   queue = GetQueue();
+    uint64_t head  = queue.head.load(std::memory_order_relaxed);
+    Slot*    pSlot = nullptr;
+    while (true) {
+        pSlot = &queue.slots[head & (LOGGER_RING_SIZE - 1)];
+        int64_t diff = int64_t(pSlot->sequence.load(std::memory_order_acquire)) - int64_t(head);
+        if (diff < 0) {
+            queue.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (diff > 0) head = queue.head.load(std::memory_order_relaxed);
+        else if (queue.head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) break;
+    }
+    
+    pSlot->level  = level;
+    pSlot->time   = time;
+    pSlot->length = UINT32(std::min<size_t>(length, LOGGER_LINE_SIZE));
+    memcpy(pSlot->text, text, pSlot->length);
+    pSlot->sequence.store(head + 1, std::memory_order_release);
+}
+
+bool Logger::isEnabled(Level level) { return level >= Threshold().load(std::memory_order_relaxed); }
+void Logger::setLevel(Level level)  { Threshold().store(level, std::memory_order_relaxed); }
+
+// Waits until the lines pushed so far are written, e.g. before exiting on an error
+void Logger::flush() {
+    if (Stopped().load()) return;
+    Queue&   queue = GetQueue();
+    uint64_t head  = queue.head.load(std::memory_order_acquire);
+    while (queue.tail.load(std::memory_order_acquire) < head)
+        std::this_thread::sleep_for(std::chrono::milliseconds(LOGGER_DRAIN_MS));
+}
+
+uint64_t Logger::getDroppedCount() {
+    if (Stopped().load()) return 0;
+    return GetQueue().dropped.load(std::memory_order_relaxed);
+}
+
+// Private ==================================================
+
+// Destroyed with the other statics, joining the drain thread after it has
+// written everything pushed before
+Logger::Queue& Logger::GetQueue() {
+    static Queue queue;
+    return queue;
+}
+
+std::atomic<bool>& Logger::Stopped() {
+    static std::atomic<bool> stopped{false};
+    return stopped;
+}
+
+std::atomic<int>& Logger::Threshold() {
+    static std::atomic<int> threshold{Verbose};
+    return threshold;
+}
+
+// stdout is flushed once per batch instead of once per line. The stopping
+// flag is read before the batch, so lines pushed before stopping are written.
+void Logger::Drain(Queue& queue) {
+    uint64_t reported = 0;
+    while (true) {
+        bool     stopping = queue.stopping.load(std::memory_order_acquire);
+        uint64_t tail     = queue.tail.load(std::memory_order_relaxed);
+        uint     written  = 0;
+        while (true) {
+            Slot& slot = queue.slots[tail & (LOGGER_RING_SIZE - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != tail + 1) break;
+            Write(slot.level, slot.time, slot.text, slot.length);
+            slot.sequence.store(tail + LOGGER_RING_SIZE, std::memory_order_release);
+            queue.tail.store(++tail, std::memory_order_release);
+            written++;
+        }
+        
+        uint64_t dropped = queue.dropped.load(std::memory_order_relaxed);
+        if (dropped > reported) {
+            char text[64];
+            int  length = snprintf(text, sizeof(text), "logger dropped %llu lines",
+                                   (unsigned long long)(dropped - reported));
+            Write(Error, TimeDif(ChronoTime::now() - Epoch()).count(), text, length);
+            reported = dropped;
+            written++;
+        }
+        
+        if (written > 0) std::cout.flush();
+        else if (stopping) return;
+        else std::this_thread::sleep_for(std::chrono::milliseconds(LOGGER_DRAIN_MS));
+    }
+}
+
+void Logger::Write(Level level, float time, const char* text, size_t length) {
+    static const char* tags[] = { "VRB::", "LOG::", "ERR::" };
+    char stamp[24];
+    snprintf(stamp, sizeof(stamp), "[%10.4f] ", time);
+    std::cout << stamp << tags[level];
+    std::cout.write(text, length) << '\n';
+}
@@ -0,0 +1,64 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+// Included by include.h before its macros, so only std is used here
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+
+#define LOGGER_RING_SIZE 4096 // Lines, a power of two
+#define LOGGER_LINE_SIZE 256  // Bytes of text per line, longer lines are cut
+
+// Leveled logging through a bounded lock-free ring. Any thread pushes lines
+// stamped with their time, a background thread writes them to stdout, so the
+// caller never waits on the terminal. A full ring drops the line and counts it
+// instead of blocking. Verbose lines are compiled out of release builds.
+class Logger {
+
+    struct Slot;
+    struct Queue;
+
+public:
+    enum Level { Verbose, Info, Error };
+    
+    static void push(Level level, const char* text, size_t length);
+    static bool isEnabled(Level level);
+    static void setLevel(Level level);
+    static void flush();
+    static uint64_t getDroppedCount();
+
+private:
+    static Queue& GetQueue();
+    static std::atomic<bool>& Stopped();
+    static std::atomic<int>&  Threshold();
+    static void Drain(Queue& queue);
+    static void Write(Level level, float time, const char* text, size_t length);
+
+};
+
+// Formats one line into a fixed buffer with stream syntax and pushes it when
+// the full expression ends. Text past LOGGER_LINE_SIZE is cut.
+class LogLine {
+
+    struct Buffer : std::streambuf {
+        char text[LOGGER_LINE_SIZE];
+        Buffer() { setp(text, text + LOGGER_LINE_SIZE); }
+        size_t length() { return size_t(pptr() - pbase()); }
+    };
+
+public:
+    ~LogLine() { Logger::push(m_level, m_buffer.text, m_buffer.length()); }
+    LogLine(Logger::Level level) : m_level(level), m_stream(&m_buffer) {}
+    
+    std::ostream& stream() { return m_stream; }
+
+private:
+    Logger::Level m_level;
+    Buffer        m_buffer;
+    std::ostream  m_stream;
+
+};
@@ -4,15 +4,61 @@
 #include <iostream>
 #include "app.hpp"
 
-int main() {
-    App app;
+// --headless [frames]  renders the default scenario offscreen, no display needed,
+//                      counts below 1 keep the scenario's own
+// --benchmark <name>   runs a named scenario instead, see Benchmark::Scenarios
+// --output <path>      writes the results as JSON
+// --baseline <path>    fails the run on regressions against earlier results
+// --threshold <ratio>  relative growth allowed against the baseline
+// --hitch <ms>         frame time dumped as a hitch_<frame>.json trace, benchmarks
+//                      only dump with it
+int main(int argc, char* argv[]) {
+    App       app;
+    Benchmark benchmark;
+    Benchmark::Scenario scenario = Benchmark::DefaultScenario();
+    STRING outputPath;
+    STRING baselinePath;
+    float  threshold = BENCHMARK_THRESHOLD;
+    float  hitch     = 0.f;
+    bool   headless  = false;
+
+    for (int i = 1; i < argc; i++) {
+        STRING arg      = argv[i];
+        bool   hasValue = i + 1 < argc && argv[i + 1][0] != '-';
+        if (arg == "--headless") {
+            headless = true;
+            if (!hasValue) continue;
+            int frames = atoi(argv[++i]);
+            if (frames > 0) scenario.frames = frames;
+            else ERR("invalid frame count " << argv[i] << ", rendering " << scenario.frames);
+        } else if (arg == "--benchmark" && hasValue) {
+            headless = true;
+            if (!Benchmark::FindScenario(argv[++i], &scenario)) return EXIT_FAILURE;
+        } else if (arg == "--output" && hasValue) {
+            outputPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            threshold = atof(argv[++i]);
+        } else if (arg == "--hitch" && hasValue) {
+            hitch = atof(argv[++i]);
+        }
+    }
+    if (headless) {
+        benchmark.setup(scenario);
+        benchmark.setOutput(outputPath);
+        benchmark.setBaseline(baselinePath, threshold);
+        app.setBenchmark(&benchmark);
+    }
+    if (headless || hitch > 0.f) System::Settings()->HitchThreshold = hitch;
 
     try {
         app.run();
     } catch (const std::exception& e) {
+        Logger::flush();
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
     }
 
-    return EXIT_SUCCESS;
+    return benchmark.hasPassed() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,172 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "system.hpp"
+#include "resources/mesh.hpp"
+#include "resources/irradiance.hpp"
+#include "resources/shader.hpp"
+#include "renderer/descriptor.hpp"
+#include "pipelines/graphics_scene.hpp"
+#include "extensions/ext_stb_image.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#define MICROBENCH_WARMUP 3
+#define MICROBENCH_REPS   20
+
+// CPU side of the asset and setup paths, timed without a Vulkan device, after
+// a correctness check of the irradiance projection. Only the work before the
+// first Vulkan call is run: meshes are built and packed but never uploaded,
+// descriptors only record their layouts and pool sizes.
+// Run from the directory holding resources/, cases whose files are missing
+// are skipped.
+struct Case {
+    STRING name;
+    STRING asset;
+    std::function<void()> run;
+};
+
+struct Stats {
+    float min;
+    float median;
+    float mean;
+    float p99;
+    float max;
+    float stddev;
+};
+
+static bool FileExists(STRING path) { return std::ifstream(path).good(); }
+
+// Logs below errors are muted, pushing them would dominate the small cases
+static VECTOR<float> Measure(std::function<void()> run, uint warmup, uint reps) {
+    VECTOR<float> samples;
+    Logger::setLevel(Logger::Error);
+    for (uint i = 0; i < warmup; i++) run();
+    for (uint i = 0; i < reps; i++) {
+        TimeVal start = ChronoTime::now();
+        run();
+        samples.push_back(TimeDif(ChronoTime::now() - start).count() * 1000.f);
+    }
+    Logger::setLevel(Logger::Verbose);
+    Logger::flush();
+    return samples;
+}
+
+static Stats Summarize(VECTOR<float> samples) {
+    std::sort(samples.begin(), samples.end());
+    size_t count = samples.size();
+    float  total = 0.f;
+    for (float sample : samples) total += sample;
+    
+    Stats stats{};
+    stats.min    = samples.front();
+    stats.median = samples[count / 2];
+    stats.mean   = total / count;
+    stats.p99    = samples[(count * 99 + 99) / 100 - 1];
+    stats.max    = samples.back();
+    for (float sample : samples) stats.stddev += (sample - stats.mean) * (sample - stats.mean);
+    stats.stddev = sqrt(stats.stddev / count);
+    return stats;
+}
+
+static void PrintHeader() {
+    std::cout << std::left << std::setw(24) << "case" << std::right;
+    for (STRING column : {"min", "median", "mean", "p99", "max", "stddev"})
+        std::cout << std::setw(10) << column;
+    std::cout << "  (ms)" << std::endl;
+}
+
+static void PrintStats(STRING name, Stats stats) {
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3);
+    for (float value : {stats.min, stats.median, stats.mean, stats.p99, stats.max, stats.stddev})
+        std::cout << std::setw(10) << value;
+    std::cout << std::endl;
+}
+
+// A constant environment of radiance L has irradiance PI * L everywhere, the
+// coefficients evaluated as the shader's irradianceSH must give back L
+static void CheckIrradiance() {
+    UInt2D size     = {64, 32};
+    float  radiance = 2.f;
+    VECTOR<float> rawHDR(size.width * size.height * 3, radiance);
+    Irradiance irradiance;
+    irradiance.projectEquirect(rawHDR.data(), size, 3);
+    glm::vec4* sh = irradiance.getCoefficients();
+    
+    for (glm::vec3 N : {glm::vec3(0, 1, 0), glm::vec3(1, 0, 0), glm::vec3(0, 0, -1), glm::normalize(glm::vec3(1))}) {
+        glm::vec3 color = glm::vec3(sh[0]) + glm::vec3(sh[1]) * N.y + glm::vec3(sh[2]) * N.z + glm::vec3(sh[3]) * N.x
+                        + glm::vec3(sh[4]) * (N.x * N.y) + glm::vec3(sh[5]) * (N.y * N.z)
+                        + glm::vec3(sh[6]) * (3.f * N.z * N.z - 1.f) + glm::vec3(sh[7]) * (N.x * N.z)
+                        + glm::vec3(sh[8]) * (N.x * N.x - N.y * N.y);
+        if (fabs(color.r - radiance) > radiance * 0.01f)
+            RUNTIME_ERROR("irradiance of a constant environment is " + std::to_string(color.r) +
+                          ", expected " + std::to_string(radiance));
+    }
+    std::cout << std::left << std::setw(24) << "irradiance.check" << "ok" << std::endl;
+}
+
+static VECTOR<Case> Cases() {
+    Files  files;
+    STRING modelPath   = MODEL_PATH + "bunny/bunny.obj";
+    STRING texturePath = files.getTextureAlbedoPath();
+    STRING hdrPath     = files.getCubemapHDRPath();
+    STRING spirvPath   = SPIRV_PATH + "main1d.frag.spv";
+    
+    // Packing is measured on its own, the sphere is built once
+    std::shared_ptr<Mesh> pSphere = std::make_shared<Mesh>();
+    pSphere->createSphere(200, 200);
+    
+    return {
+        { "mesh.sphere",       "",          [](){ Mesh mesh; mesh.createSphere(200, 200); } },
+        { "mesh.load_model",   modelPath,   [=](){ Mesh mesh; mesh.loadModel(modelPath.c_str()); } },
+        { "mesh.pack_vertices","",          [=](){ pSphere->packVertices(); } },
+        { "stbi.load_image",   texturePath, [=](){
+            int width, height, channels;
+            stbi_image_free(STBI::LoadImage(texturePath, &width, &height, &channels));
+        } },
+        { "stbi.load_hdr",     hdrPath,     [=](){
+            int width, height, channels;
+            stbi_image_free(STBI::LoadHDR(hdrPath, &width, &height, &channels));
+        } },
+        { "shader.read_binary", spirvPath,  [=](){ Shader::ReadBinaryFile(spirvPath); } },
+        { "descriptor.setup",  "",          [](){ Descriptor descriptor; GraphicsScene::SetupDescriptorLayouts(&descriptor); } },
+    };
+}
+
+// [filter]             runs the cases whose name contains it
+// --warmup <count>     untimed runs before measuring
+// --reps <count>       timed runs
+int main(int argc, char* argv[]) {
+    STRING filter;
+    uint   warmup = MICROBENCH_WARMUP;
+    uint   reps   = MICROBENCH_REPS;
+    
+    for (int i = 1; i < argc; i++) {
+        STRING arg      = argv[i];
+        bool   hasValue = i + 1 < argc;
+        if      (arg == "--warmup" && hasValue) warmup = atoi(argv[++i]);
+        else if (arg == "--reps"   && hasValue) reps   = std::max(atoi(argv[++i]), 1);
+        else if (arg[0] != '-')                 filter = arg;
+    }
+    
+    PrintHeader();
+    try {
+        CheckIrradiance();
+        for (Case& bench : Cases()) {
+            if (bench.name.find(filter) == STRING::npos) continue;
+            if (!bench.asset.empty() && !FileExists(bench.asset)) {
+                std::cout << std::left << std::setw(24) << bench.name << "skipped, missing " << bench.asset << std::endl;
+                continue;
+            }
+            PrintStats(bench.name, Summarize(Measure(bench.run, warmup, reps)));
+        }
+    } catch (const std::exception& e) {
+        Logger::flush();
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
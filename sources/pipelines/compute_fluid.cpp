@@ -33,47 +33,42 @@ void ComputeFluid::updateInterferenceInput(Image* pInterferenceImage) {
 }
 
 void ComputeFluid::setupOutput() {
+    VECTOR<uint32_t> queueFamilies = {
+        m_pDevice->getGraphicQueueIndex(), m_pDevice->getComputeQueueIndex()
+    };
+    
     m_pSampledImage = new Image();
     m_pSampledImage->setupForStorage(m_details.size);
+    m_pSampledImage->setMemoryTag(MEMORY_TAG_SIM);
+    m_pSampledImage->setSharedQueues(queueFamilies);
     m_pSampledImage->createWithSampler();
     m_pSampledImage->cmdClearColorImage();
     m_pSampledImage->cmdTransitionToShaderR();
-    
-    m_pFluidImage = new Image();
-    m_pFluidImage->setupForStorage(m_details.size);
-    m_pFluidImage->createWithSampler();
-    m_pFluidImage->cmdClearColorImage();
-    m_pFluidImage->cmdTransitionToStorageW();
-    
-    m_pHeightImage = new Image();
-    m_pHeightImage->setupForStorage(m_details.size);
-    m_pHeightImage->createWithSampler();
-    m_pHeightImage->cmdClearColorImage();
-    m_pHeightImage->cmdTransitionToStorageW();
-    
-    m_pIridescentImage = new Image();
-    m_pIridescentImage->setupForStorage(m_details.size);
-    m_pIridescentImage->createWithSampler();
-    m_pIridescentImage->cmdClearColorImage();
-    m_pIridescentImage->cmdTransitionToStorageW();
-    
-    m_pDescriptor->setupPointerImage(S0, B0, m_pSampledImage->getDescriptorInfo());
-    m_pDescriptor->setupPointerImage(S0, B1, m_pFluidImage->getDescriptorInfo());
-    m_pDescriptor->setupPointerImage(S0, B2, m_pHeightImage->getDescriptorInfo());
-    m_pDescriptor->setupPointerImage(S0, B3, m_pIridescentImage->getDescriptorInfo());
-    m_pDescriptor->update(S0);
-    
     m_cleaner.push([=](){ m_pSampledImage->cleanup(); });
-    m_cleaner.push([=](){ m_pFluidImage->cleanup(); });
-    m_cleaner.push([=](){ m_pHeightImage->cleanup(); });
-    m_cleaner.push([=](){ m_pIridescentImage->cleanup(); });
+    
+    m_pFluidImages     .resize(SIMULATION_SLOT_COUNT);
+    m_pHeightImages    .resize(SIMULATION_SLOT_COUNT);
+    m_pIridescentImages.resize(SIMULATION_SLOT_COUNT);
+    for (uint i = 0; i < SIMULATION_SLOT_COUNT; i++) {
+        m_pFluidImages[i]      = createOutputImage(queueFamilies);
+        m_pHeightImages[i]     = createOutputImage(queueFamilies);
+        m_pIridescentImages[i] = createOutputImage(queueFamilies);
+        
+        m_pDescriptor->setupPointerImage(S0, i, B0, m_pSampledImage->getDescriptorInfo());
+        m_pDescriptor->setupPointerImage(S0, i, B1, m_pFluidImages[i]->getDescriptorInfo());
+        m_pDescriptor->setupPointerImage(S0, i, B2, m_pHeightImages[i]->getDescriptorInfo());
+        m_pDescriptor->setupPointerImage(S0, i, B3, m_pIridescentImages[i]->getDescriptorInfo());
+        m_pDescriptor->update(S0);
+    }
 }
 
+void ComputeFluid::setSlot(uint slot) { m_slot = slot; }
+
 void ComputeFluid::createDescriptor() {
     LOG("ComputeFluid::createDescriptor");
     m_pDescriptor = new Descriptor();
     
-    m_pDescriptor->setupLayout(S0);
+    m_pDescriptor->setupLayout(S0, SIMULATION_SLOT_COUNT);
     m_pDescriptor->addLayoutBindings(S0, B0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                                      VK_SHADER_STAGE_COMPUTE_BIT);
     m_pDescriptor->addLayoutBindings(S0, B1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
@@ -136,7 +131,7 @@ void ComputeFluid::dispatch(VkCommandBuffer cmdBuffer) {
     VkPipelineLayout  pipelineLayout = m_pipelineLayout;
     VkPipeline        pipeline = m_pPipeline->get();
     PCMisc            details  = m_details;
-    VkDescriptorSet   outputDescSet = m_pDescriptor->getDescriptorSet(S0);
+    VkDescriptorSet   outputDescSet = m_pDescriptor->getDescriptorSet(S0, m_slot);
     VkDescriptorSet   interferenceDescSet = m_pDescriptor->getDescriptorSet(S1);
     
     m_details.thicknessScale   = System::Settings()->ThicknessScale;
@@ -144,10 +139,6 @@ void ComputeFluid::dispatch(VkCommandBuffer cmdBuffer) {
     m_details.reflectanceValue = System::Settings()->ReflectanceValue;
     m_details.opdOffset        = System::Settings()->OPDOffset;
     
-    m_pFluidImage->cmdTransitionToStorageW(cmdBuffer);
-    m_pHeightImage->cmdTransitionToStorageW(cmdBuffer);
-    m_pIridescentImage->cmdTransitionToStorageW(cmdBuffer);
-    
     vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
                        0, sizeof(PCMisc), &details);
     vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
@@ -160,18 +151,59 @@ void ComputeFluid::dispatch(VkCommandBuffer cmdBuffer) {
     vkCmdDispatch(cmdBuffer,
                   details.size.width  / WORKGROUP_SIZE_X + 1,
                   details.size.height / WORKGROUP_SIZE_Y + 1, 1);
-    
-    m_pFluidImage->cmdTransitionToTransferSrc(cmdBuffer);
-    m_pSampledImage->cmdTransitionToTransferDst(cmdBuffer);
-    
-    m_pSampledImage->cmdCopyImageToImage(cmdBuffer, m_pFluidImage);
-    
-    m_pSampledImage->cmdTransitionToShaderR(cmdBuffer);
-    m_pFluidImage->cmdTransitionToShaderR(cmdBuffer);
-    m_pHeightImage->cmdTransitionToShaderR(cmdBuffer);
-    m_pIridescentImage->cmdTransitionToShaderR(cmdBuffer);
 }
 
-Image * ComputeFluid::getFluidImage     () { return m_pFluidImage;  }
-Image * ComputeFluid::getHeightImage    () { return m_pHeightImage; }
-Image * ComputeFluid::getIridescentImage() { return m_pIridescentImage; }
+// The fluid output becomes the state the next dispatch samples
+void ComputeFluid::copyState(VkCommandBuffer cmdBuffer) {
+    m_pSampledImage->cmdCopyImageToImage(cmdBuffer, m_pFluidImages[m_slot]);
+}
+
+// Runs on the compute queue. The slot outputs are handed to graphics in
+// shader read layout; the semaphore wait makes them visible there.
+void ComputeFluid::addPasses(RenderGraph* pGraph, bool enabled) {
+    Image* pSampledImage    = m_pSampledImage;
+    Image* pFluidImage      = m_pFluidImages[m_slot];
+    Image* pHeightImage     = m_pHeightImages[m_slot];
+    Image* pIridescentImage = m_pIridescentImages[m_slot];
+    
+    uint pass = pGraph->addPass("fluid", [=](VkCommandBuffer cmdBuffer){ dispatch(cmdBuffer); }, enabled);
+    pGraph->readImage (pass, pSampledImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                       VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    pGraph->readImage (pass, m_pInterferenceImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                       VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    for (Image* pImage : { pFluidImage, pHeightImage, pIridescentImage }) {
+        pGraph->writeImage(pass, pImage, VK_IMAGE_LAYOUT_GENERAL,
+                           VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, true);
+    }
+    
+    pass = pGraph->addPass("fluid copy", [=](VkCommandBuffer cmdBuffer){ copyState(cmdBuffer); }, enabled);
+    pGraph->readImage (pass, pFluidImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    pGraph->writeImage(pass, pSampledImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, true);
+    
+    pGraph->exportImage(pSampledImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    for (Image* pImage : { pFluidImage, pHeightImage, pIridescentImage }) {
+        pGraph->exportImage(pImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            0, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    }
+}
+
+VECTOR<Image*> ComputeFluid::getFluidImages     () { return m_pFluidImages;      }
+VECTOR<Image*> ComputeFluid::getHeightImages    () { return m_pHeightImages;     }
+VECTOR<Image*> ComputeFluid::getIridescentImages() { return m_pIridescentImages; }
+
+// Private ==================================================
+
+Image* ComputeFluid::createOutputImage(VECTOR<uint32_t> queueFamilies) {
+    Image* pImage = new Image();
+    pImage->setupForStorage(m_details.size);
+    pImage->setMemoryTag(MEMORY_TAG_SIM);
+    pImage->setSharedQueues(queueFamilies);
+    pImage->createWithSampler();
+    pImage->cmdClearColorImage();
+    pImage->cmdTransitionToShaderR();
+    m_cleaner.push([=](){ pImage->cleanup(); });
+    return pImage;
+}
@@ -7,6 +7,7 @@
 #include "../renderer/device.hpp"
 #include "../renderer/pipeline.hpp"
 #include "../renderer/descriptor.hpp"
+#include "../renderer/render_graph.hpp"
 #include "../resources/image.hpp"
 #include "../resources/buffer.hpp"
 
@@ -26,20 +27,23 @@ public:
     
     void cleanup();
     void dispatch(VkCommandBuffer cmdBuffer);
+    void copyState(VkCommandBuffer cmdBuffer);
+    void addPasses(RenderGraph* pGraph, bool enabled);
     
     void setupShader();
     void setupInput();
     void setupOutput();
     
     void updateInterferenceInput(Image* pInterferenceImage);
+    void setSlot(uint slot);
     
     void createDescriptor();
     void createPipelineLayout();
     void createPipeline();
     
-    Image* getFluidImage();
-    Image* getHeightImage();
-    Image* getIridescentImage();
+    VECTOR<Image*> getFluidImages();
+    VECTOR<Image*> getHeightImages();
+    VECTOR<Image*> getIridescentImages();
     
 private:
     Cleaner m_cleaner;
@@ -47,10 +51,14 @@ private:
     Pipeline* m_pPipeline;
     Descriptor* m_pDescriptor;
     
+    // Simulation state, only touched by the compute queue
     Image* m_pSampledImage;
-    Image* m_pFluidImage;
-    Image* m_pHeightImage;
-    Image* m_pIridescentImage;
+    
+    // Outputs per simulation slot, read by graphics
+    uint m_slot = 0;
+    VECTOR<Image*> m_pFluidImages;
+    VECTOR<Image*> m_pHeightImages;
+    VECTOR<Image*> m_pIridescentImages;
     
     Image* m_pInterferenceImage;
     
@@ -60,4 +68,6 @@ private:
     
     VkPushConstantRange m_pushConstantRange;
     VkPipelineShaderStageCreateInfo m_shaderStage;
+    
+    Image* createOutputImage(VECTOR<uint32_t> queueFamilies);
 };
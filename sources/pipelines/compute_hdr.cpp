@@ -21,14 +21,14 @@ void ComputeHDR::setupShader() {
     m_cleaner.push([=](){ compShader->cleanup(); });
 }
 
-void ComputeHDR::cleanInputOutput() { m_pOutputImage->cleanup(); m_pInputBuffer->cleanup(); }
-void ComputeHDR::setupInputOutput(std::string hdrPath) {
+// Both images are created by the caller. The storage image carries the loaded
+// HDR and receives the compute output, the texture image gets the mipmapped copy.
+void ComputeHDR::cleanInputOutput() { m_pInputBuffer->cleanup(); }
+void ComputeHDR::setupInputOutput(Image* pStorageImage, Image* pTextureImage) {
     LOG("ComputeHDR::setupInputOutput");
-    m_pOutputImage = new Image();
-    m_pOutputImage->setupForHDRTexture(hdrPath);
-    m_pOutputImage->createWithSampler();
+    m_pOutputImage  = pStorageImage;
+    m_pTextureImage = pTextureImage;
     m_pOutputImage->cmdTransitionToStorageW();
-    m_cleaner.push([=](){ m_pOutputImage->cleanup(); });
     
     float* imageData = m_pOutputImage->getRawHDR();
     UInt2D imageSize = m_pOutputImage->getImageSize();
@@ -37,9 +37,9 @@ void ComputeHDR::setupInputOutput(std::string hdrPath) {
     
     m_pInputBuffer = new Buffer();
     m_pInputBuffer->setup(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    m_pInputBuffer->setMemoryTag(MEMORY_TAG_IBL);
     m_pInputBuffer->create();
     m_pInputBuffer->fillBufferFull(imageData);
-    m_cleaner.push([=](){ m_pInputBuffer->cleanup(); });
     
     m_pDescriptor->setupPointerBuffer(S0, B0, m_pInputBuffer->getDescriptorInfo());
     m_pDescriptor->setupPointerImage(S0, B1, m_pOutputImage->getDescriptorInfo());
@@ -98,10 +98,7 @@ void ComputeHDR::createPipeline() {
 }
 
 Image* ComputeHDR::dispatch() {
-    UInt2D imageSize = m_pOutputImage->getImageSize();
-    Image* imageOutput = new Image();
-    imageOutput->setupForHDRTexture(imageSize);
-    imageOutput->createWithSampler();
+    Image* imageOutput = m_pTextureImage;
     
     Commander* pCommander = System::Commander();
     VkCommandBuffer cmdBuffer = pCommander->createCommandBuffer();
@@ -136,3 +133,5 @@ void ComputeHDR::dispatch(VkCommandBuffer cmdBuffer) {
     
     m_pOutputImage->cmdTransitionToTransferSrc(cmdBuffer);
 }
+
+Image* ComputeHDR::getSourceImage() { return m_pOutputImage; }
@@ -24,19 +24,22 @@ public:
     Image* dispatch();
     
     void setupShader();
-    void setupInputOutput(std::string hdrPath);
+    void setupInputOutput(Image* pStorageImage, Image* pTextureImage);
     void cleanInputOutput();
     
     void createDescriptor();
     void createPipelineLayout();
     void createPipeline();
     
+    Image* getSourceImage();
+    
 private:
     Cleaner m_cleaner;
     Pipeline* m_pPipeline;
     Descriptor* m_pDescriptor;
     
     Image*  m_pOutputImage;
+    Image*  m_pTextureImage;
     Buffer* m_pInputBuffer;
     
     PCMisc m_misc;
@@ -115,6 +115,9 @@ Image* ComputeInterference::copyOutputImage() {
     UInt2D imageSize = m_pOutputImage->getImageSize();
     Image* imageCopy = new Image();
     imageCopy->setupForStorage(imageSize);
+    // Sampled by both the scene and the fluid simulation on the compute queue
+    Device* pDevice = System::Device();
+    imageCopy->setSharedQueues({ pDevice->getGraphicQueueIndex(), pDevice->getComputeQueueIndex() });
     imageCopy->createWithSampler();
     
     Commander* pCommander = System::Commander();
@@ -29,6 +29,7 @@ void ComputeMarking::setupInput(Image* image, Buffer *buffer) {
     
     m_pOutputImage = new Image();
     m_pOutputImage->setupForStorage({m_misc.size.width, 1});
+    m_pOutputImage->setMemoryTag(MEMORY_TAG_SIM);
     m_pOutputImage->createWithSampler();
     m_pOutputImage->cmdTransitionToStorageW();
     m_cleaner.push([=](){ m_pOutputImage->cleanup(); });
@@ -108,4 +109,14 @@ void ComputeMarking::dispatch(VkCommandBuffer cmdBuffer) {
     
 }
 
+// The output keeps its previous marks, so it is written without a discard
+void ComputeMarking::addPass(RenderGraph* pGraph) {
+    uint pass = pGraph->addPass("marking", [=](VkCommandBuffer cmdBuffer){ dispatch(cmdBuffer); });
+    pGraph->readBuffer(pass, m_pMarkBuffer, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    pGraph->readImage (pass, m_pInputImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                       VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    pGraph->writeImage(pass, m_pOutputImage, VK_IMAGE_LAYOUT_GENERAL,
+                       VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+}
+
 Image* ComputeMarking::getOutputImage() { return m_pOutputImage; }
@@ -6,6 +6,7 @@
 #include "../include.h"
 #include "../renderer/pipeline.hpp"
 #include "../renderer/descriptor.hpp"
+#include "../renderer/render_graph.hpp"
 #include "../resources/image.hpp"
 #include "../resources/buffer.hpp"
 
@@ -21,6 +22,7 @@ public:
     
     void cleanup();
     void dispatch(VkCommandBuffer cmdBuffer);
+    void addPass(RenderGraph* pGraph);
     
     void setupShader();
     void setupInput(Image* image, Buffer* buffer);
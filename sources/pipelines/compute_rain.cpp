@@ -41,6 +41,7 @@ void ComputeRain::setupInput() {
     uint bufferSize = m_misc.amount * sizeof(glm::vec4);
     m_pPositionBuffer = new Buffer();
     m_pPositionBuffer->setup(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    m_pPositionBuffer->setMemoryTag(MEMORY_TAG_SIM);
     m_pPositionBuffer->create();
     m_pPositionBuffer->fillBufferFull(positions.data());
     m_cleaner.push([=](){ m_pPositionBuffer->cleanup(); });
@@ -113,3 +114,12 @@ void ComputeRain::dispatch(VkCommandBuffer cmdBuffer) {
                   1, 1);
     
 }
+
+// The drops are drawn by the scene on the graphics queue, which waits on the
+// compute submission, so the pass is a root of the compute graph
+void ComputeRain::addPass(RenderGraph* pGraph, bool enabled) {
+    uint pass = pGraph->addPass("rain", [=](VkCommandBuffer cmdBuffer){ dispatch(cmdBuffer); }, enabled);
+    pGraph->setRoot(pass);
+    pGraph->writeBuffer(pass, m_pPositionBuffer, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+}
@@ -6,6 +6,7 @@
 #include "../include.h"
 #include "../renderer/pipeline.hpp"
 #include "../renderer/descriptor.hpp"
+#include "../renderer/render_graph.hpp"
 #include "../resources/buffer.hpp"
 
 class ComputeRain {
@@ -22,6 +23,7 @@ public:
     
     void cleanup();
     void dispatch(VkCommandBuffer cmdBuffer);
+    void addPass(RenderGraph* pGraph, bool enabled);
     
     void setupShader();
     void setupInput();
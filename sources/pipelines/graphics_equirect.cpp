@@ -72,7 +72,7 @@ Image* GraphicsEquirect::render() {
     render(cmdBuffer);
     imageFrame->cmdTransitionToTransferSrc(cmdBuffer);
     imageOutput->cmdTransitionToTransferDst(cmdBuffer);
-    imageOutput->cmdCopyImageToImage(cmdBuffer, imageFrame);
+    imageOutput->cmdBlitImageToImage(cmdBuffer, imageFrame, {imageSize.width, imageSize.height, 1});
     imageOutput->cmdGenerateMipmaps(cmdBuffer);
     pCommander->endSingleTimeCommands(cmdBuffer);
     
@@ -118,7 +118,7 @@ void GraphicsEquirect::createDescriptor() {
 
 void GraphicsEquirect::createRenderpass() {
     m_pRenderpass = new Renderpass();
-    m_pRenderpass->setupColorAttachment(VK_FORMAT_R32G32B32A32_SFLOAT);
+    m_pRenderpass->setupColorAttachment(System::Device()->getHDRAttachmentFormat());
     m_pRenderpass->setup();
     m_pRenderpass->create();
     m_cleaner.push([=](){ m_pRenderpass->cleanup(); });
@@ -183,6 +183,14 @@ void GraphicsEquirect::createFrame(uint32_t size) {
     updateViewportScissor();
 }
 
+void GraphicsEquirect::createFrame(Image* pColorImage) {
+    LOG("GraphicsEquirect::createFrame");
+    m_pFrame = new Frame(pColorImage->getImageSize());
+    m_pFrame->createCubeResource(pColorImage);
+    m_pFrame->createFramebuffer(m_pRenderpass);
+    updateViewportScissor();
+}
+
 void GraphicsEquirect::updateViewportScissor() {
     UInt2D extent = m_pFrame->getSize();
     m_viewport.x = 0.f;
@@ -36,6 +36,7 @@ public:
     void createPipeline();
     void createRenderpass();
     void createFrame(uint32_t size);
+    void createFrame(Image* pColorImage);
     void cleanFrame();
     
 private:
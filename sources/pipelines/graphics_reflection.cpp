@@ -61,7 +61,7 @@ void GraphicsReflection::render(VkCommandBuffer cmdBuffer) {
 }
 
 Image* GraphicsReflection::render() {
-    UInt2D imageSize = m_pInputImage->getImageSize();
+    UInt2D imageSize = m_pFrame->getSize();
     Image* imageFrame = m_pFrame->getColorImage();
     Image* imageOutput = new Image();
     imageOutput->setupForCubemap(imageSize);
@@ -81,7 +81,7 @@ Image* GraphicsReflection::render() {
         updateViewportScissor(size);
         render(cmdBuffer);
         imageFrame->cmdTransitionToTransferSrc(cmdBuffer);
-        imageOutput->cmdCopyImageToImage(cmdBuffer, imageFrame, extent, 0, l);
+        imageOutput->cmdBlitImageToImage(cmdBuffer, imageFrame, extent, 0, l);
         imageFrame->cmdTransitionToPresent(cmdBuffer);
     }
     pCommander->endSingleTimeCommands(cmdBuffer);
@@ -128,7 +128,7 @@ void GraphicsReflection::createDescriptor() {
 
 void GraphicsReflection::createRenderpass() {
     m_pRenderpass = new Renderpass();
-    m_pRenderpass->setupColorAttachment(VK_FORMAT_R32G32B32A32_SFLOAT);
+    m_pRenderpass->setupColorAttachment(System::Device()->getHDRAttachmentFormat());
     m_pRenderpass->setup();
     m_pRenderpass->create();
     m_cleaner.push([=](){ m_pRenderpass->cleanup(); });
@@ -183,14 +183,22 @@ void GraphicsReflection::createPipeline() {
     m_cleaner.push([=](){ m_pPipeline->cleanup(); });
 }
 
-void GraphicsReflection::createFrame() {
+void GraphicsReflection::cleanFrame() { m_pFrame->cleanup(); }
+void GraphicsReflection::createFrame(uint32_t size) {
     LOG("GraphicsReflection::createFrame");
-    m_pFrame = new Frame(m_pInputImage->getImageSize());
+    m_pFrame = new Frame({size, size});
     m_pFrame->createCubeResource();
     m_pFrame->createFramebuffer(m_pRenderpass);
     m_cleaner.push([=](){ m_pFrame->cleanup(); });
 }
 
+void GraphicsReflection::createFrame(Image* pColorImage) {
+    LOG("GraphicsReflection::createFrame");
+    m_pFrame = new Frame(pColorImage->getImageSize());
+    m_pFrame->createCubeResource(pColorImage);
+    m_pFrame->createFramebuffer(m_pRenderpass);
+}
+
 void GraphicsReflection::updateViewportScissor(UInt2D size) {
     m_viewport.x = 0.f;
     m_viewport.y = 0.f;
@@ -36,7 +36,9 @@ public:
     void createPipelineLayout();
     void createPipeline();
     void createRenderpass();
-    void createFrame();
+    void createFrame(uint32_t size);
+    void createFrame(Image* pColorImage);
+    void cleanFrame();
     
 private:
     Cleaner m_cleaner;
@@ -6,37 +6,20 @@
 #include "../system.hpp"
 #include "../resources/shader.hpp"
 
+#define CUBEMAP_SET_COUNT 2
+#define TEXTURE_SET_COUNT 2
+
 GraphicsScene::~GraphicsScene() {}
 GraphicsScene::GraphicsScene() : m_pDevice(System::Device()) {}
 
 void GraphicsScene::cleanup() { m_cleaner.flush("GraphicsScene"); }
 
+// The draws were recorded on a worker and the skybox is replayed from its
+// static recording, the primary only runs the render pass
 void GraphicsScene::render(VkCommandBuffer cmdBuffer) {
-    Settings* settings = System::Settings();
-    VkPipelineLayout pipelineLayout  = m_pipelineLayout;
-    VkPipeline       meshPipeline    = m_pMeshPipeline->get();
-    VkPipeline       cubemapPipeline = m_pCubemapPipeline->get();
     VkRenderPass     renderpass      = m_pRenderpass->get();
     VkFramebuffer    framebuffer     = m_pFrame->getFramebuffer();
     VkRect2D         scissor         = m_scissor;
-    VkViewport       viewport        = m_viewport;
-    Mesh *mesh = m_pMesh[settings->Shapes];
-    
-    VkDeviceSize offsets  = 0;
-    VkBuffer meshVertexBuffer = mesh->getVertexBuffer()->get();
-    VkBuffer meshIndexBuffer  = mesh->getIndexBuffer()->get();
-    uint32_t meshIndexSize    = mesh->getIndexSize();
-    VkBuffer cubeVertexBuffer = m_pCube->getVertexBuffer()->get();
-    VkBuffer cubeIndexBuffer  = m_pCube->getIndexBuffer()->get();
-    uint32_t cubeIndexSize    = m_pCube->getIndexSize();
-    
-    
-    VkDescriptorSet cameraDescSet  = m_pDescriptor->getDescriptorSet(S0);
-    VkDescriptorSet miscDescSet = m_pDescriptor->getDescriptorSet(S1);
-    VkDescriptorSet textureDescSet = m_pDescriptor->getDescriptorSet(S2);
-    VkDescriptorSet heightmapDescSet = m_pDescriptor->getDescriptorSet(S3);
-    VkDescriptorSet interferenceDescSet = m_pDescriptor->getDescriptorSet(S4);
-    VkDescriptorSet cubemapDescSet = m_pDescriptor->getDescriptorSet(S5);
     
     std::array<VkClearValue, 2> clearValues{};
     clearValues[0].color = System::Settings()->ClearColor;
@@ -50,14 +33,47 @@ void GraphicsScene::render(VkCommandBuffer cmdBuffer) {
     renderBeginInfo.framebuffer     = framebuffer;
     renderBeginInfo.renderArea      = scissor;
     
-    Buffer* pMarkBuffer = m_pMarkBuffer;
-    pMarkBuffer->cmdClearBuffer(cmdBuffer, 0.2);
+    std::array<VkCommandBuffer, 2> drawBuffers{};
+    drawBuffers[0] = m_pSkyboxCommands->get(m_frameIdx, [=](VkCommandBuffer skyboxBuffer){
+        recordSkybox(skyboxBuffer);
+    });
+    drawBuffers[1] = m_pRecorder->wait(m_drawJob);
+    
+    vkCmdBeginRenderPass(cmdBuffer, &renderBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(cmdBuffer, UINT32(drawBuffers.size()), drawBuffers.data());
+    vkCmdEndRenderPass(cmdBuffer);
+}
+
+// Starts recording the mesh and light draws into a secondary buffer
+void GraphicsScene::recordAsync(Recorder* pRecorder) {
+    VkRenderPass  renderpass  = m_pRenderpass->get();
+    VkFramebuffer framebuffer = m_pFrame->getFramebuffer();
+    
+    m_pRecorder = pRecorder;
+    m_drawJob   = pRecorder->record(renderpass, framebuffer,
+                                    [=](VkCommandBuffer cmdBuffer){ recordDraws(cmdBuffer); });
+}
+
+// The skybox only depends on the frame's camera set, the active cubemap set
+// and the frame size, so it is recorded once per frame in flight and again
+// after a resize or cubemap swap
+void GraphicsScene::recordSkybox(VkCommandBuffer cmdBuffer) {
+    VkPipelineLayout pipelineLayout  = m_pipelineLayout;
+    VkPipeline       cubemapPipeline = m_pCubemapPipeline->get();
+    VkRect2D         scissor         = m_scissor;
+    VkViewport       viewport        = m_viewport;
+    
+    VkDeviceSize offsets  = 0;
+    VkBuffer cubeVertexBuffer = m_pCube->getVertexBuffer()->get();
+    VkBuffer cubeIndexBuffer  = m_pCube->getIndexBuffer()->get();
+    uint32_t cubeIndexSize    = m_pCube->getIndexSize();
+    
+    VkDescriptorSet cameraDescSet  = m_pDescriptor->getDescriptorSet(S0, m_frameIdx);
+    VkDescriptorSet cubemapDescSet = m_pDescriptor->getDescriptorSet(S5, m_cubemapSetIdx);
     
     vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
     vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
     
-    vkCmdBeginRenderPass(cmdBuffer, &renderBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-    
     vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, cubemapPipeline);
     
     vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -69,6 +85,31 @@ void GraphicsScene::render(VkCommandBuffer cmdBuffer) {
     vkCmdBindIndexBuffer  (cmdBuffer, cubeIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
     
     vkCmdDrawIndexed(cmdBuffer, cubeIndexSize, 1, 0, 0, 0);
+}
+
+// Viewport and scissor are not inherited, the secondary sets its own
+void GraphicsScene::recordDraws(VkCommandBuffer cmdBuffer) {
+    Settings* settings = System::Settings();
+    VkPipelineLayout pipelineLayout  = m_pipelineLayout;
+    VkPipeline       meshPipeline    = m_pMeshPipeline->get();
+    VkRect2D         scissor         = m_scissor;
+    VkViewport       viewport        = m_viewport;
+    Mesh *mesh = m_pMesh[settings->Shapes];
+    
+    VkDeviceSize offsets  = 0;
+    VkBuffer meshVertexBuffer = mesh->getVertexBuffer()->get();
+    VkBuffer meshIndexBuffer  = mesh->getIndexBuffer()->get();
+    uint32_t meshIndexSize    = mesh->getIndexSize();
+    
+    VkDescriptorSet cameraDescSet  = m_pDescriptor->getDescriptorSet(S0, m_frameIdx);
+    VkDescriptorSet miscDescSet = m_pDescriptor->getDescriptorSet(S1, m_frameIdx);
+    VkDescriptorSet textureDescSet = m_pDescriptor->getDescriptorSet(S2, m_textureSetIdx);
+    VkDescriptorSet heightmapDescSet = m_pDescriptor->getDescriptorSet(S3, m_simulationSlot);
+    VkDescriptorSet interferenceDescSet = m_pDescriptor->getDescriptorSet(S4);
+    VkDescriptorSet cubemapDescSet = m_pDescriptor->getDescriptorSet(S5, m_cubemapSetIdx);
+    
+    vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
     
     vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, meshPipeline);
     
@@ -102,8 +143,32 @@ void GraphicsScene::render(VkCommandBuffer cmdBuffer) {
         
         vkCmdDrawIndexed(cmdBuffer, meshIndexSize, 1, 0, 0, 0);
     }
-    
-    vkCmdEndRenderPass(cmdBuffer);
+}
+
+void GraphicsScene::clearMarkBuffer(VkCommandBuffer cmdBuffer) {
+    m_pMarkBuffer->cmdClearBuffer(cmdBuffer, 0.2);
+}
+
+// The renderpass clears the color target and keeps it in attachment layout,
+// the graph moves it on to whichever pass samples it. Depth never leaves the
+// renderpass, so it is not declared here.
+void GraphicsScene::addPasses(RenderGraph* pGraph) {
+    Buffer* pMarkBuffer   = m_pMarkBuffer;
+    Image*  pHeightmap    = m_pHeightmaps[m_simulationSlot];
+    Image*  pInterference = m_pInterference;
+    
+    uint pass = pGraph->addPass("mark clear", [=](VkCommandBuffer cmdBuffer){ clearMarkBuffer(cmdBuffer); });
+    pGraph->writeBuffer(pass, pMarkBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    
+    pass = pGraph->addPass("scene", [=](VkCommandBuffer cmdBuffer){ render(cmdBuffer); });
+    pGraph->writeImage (pass, m_pColorImage, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, true);
+    pGraph->writeBuffer(pass, pMarkBuffer, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    pGraph->readImage  (pass, pHeightmap, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    pGraph->readImage  (pass, pInterference, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
 }
 
 void GraphicsScene::setupShader() {
@@ -120,27 +185,42 @@ void GraphicsScene::setupInput() {
     LOG("GraphicsScene::setupInput");
     m_lights.total = System::Settings()->TotalLight;
     
-    m_pCameraBuffer = new Buffer();
-    m_pCameraBuffer->setup(sizeof(UBCamera), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
-    m_pCameraBuffer->create();
-    m_cleaner.push([=](){ m_pCameraBuffer->cleanup(); });
-    
-    m_pLightBuffer = new Buffer();
-    m_pLightBuffer->setup(sizeof(UBLights), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
-    m_pLightBuffer->create();
-    m_cleaner.push([=](){ m_pLightBuffer->cleanup(); });
-    
-    m_pParamBuffer = new Buffer();
-    m_pParamBuffer->setup(sizeof(UBParam), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
-    m_pParamBuffer->create();
-    m_cleaner.push([=](){ m_pParamBuffer->cleanup(); });
+    m_pCameraBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    m_pLightBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    m_pParamBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    for (uint i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        m_pCameraBuffers[i] = new Buffer();
+        m_pCameraBuffers[i]->setup(sizeof(UBCamera), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+        m_pCameraBuffers[i]->create();
+        m_cleaner.push([=](){ m_pCameraBuffers[i]->cleanup(); });
+        
+        m_pLightBuffers[i] = new Buffer();
+        m_pLightBuffers[i]->setup(sizeof(UBLights), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+        m_pLightBuffers[i]->create();
+        m_cleaner.push([=](){ m_pLightBuffers[i]->cleanup(); });
+        
+        m_pParamBuffers[i] = new Buffer();
+        m_pParamBuffers[i]->setup(sizeof(UBParam), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+        m_pParamBuffers[i]->create();
+        m_cleaner.push([=](){ m_pParamBuffers[i]->cleanup(); });
+        
+        m_pDescriptor->setupPointerBuffer(S0, i, B0, m_pCameraBuffers[i]->getDescriptorInfo());
+        m_pDescriptor->update(S0);
+        m_pDescriptor->setupPointerBuffer(S1, i, B0, m_pLightBuffers[i]->getDescriptorInfo());
+        m_pDescriptor->setupPointerBuffer(S1, i, B1, m_pParamBuffers[i]->getDescriptorInfo());
+        m_pDescriptor->update(S1);
+    }
     
-    m_pDescriptor->setupPointerBuffer(S0, B0, m_pCameraBuffer->getDescriptorInfo());
-    m_pDescriptor->setupPointerBuffer(S1, B0, m_pLightBuffer->getDescriptorInfo());
-    m_pDescriptor->setupPointerBuffer(S1, B1, m_pParamBuffer->getDescriptorInfo());
+    m_cubemapSetValues.resize(CUBEMAP_SET_COUNT, 0);
+    m_textureSetValues.resize(TEXTURE_SET_COUNT, 0);
     
-    m_pDescriptor->update(S0);
-    m_pDescriptor->update(S1);
+    m_pIrradianceBuffers.resize(CUBEMAP_SET_COUNT);
+    for (uint i = 0; i < CUBEMAP_SET_COUNT; i++) {
+        m_pIrradianceBuffers[i] = new Buffer();
+        m_pIrradianceBuffers[i]->setup(sizeof(UBIrradiance), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+        m_pIrradianceBuffers[i]->create();
+        m_cleaner.push([=](){ m_pIrradianceBuffers[i]->cleanup(); });
+    }
     
     Mesh* cube = new Mesh();
     cube->createCube();
@@ -170,42 +250,61 @@ void GraphicsScene::setupInput() {
     m_pCube = cube;
 }
 
+void GraphicsScene::setupRenderGraph(RenderGraph* pGraph) { m_pRenderGraph = pGraph; }
+
+// Like the cubemap, the textures alternate between two descriptor sets. The
+// replaced images are retired and released once the frames using them complete.
 void GraphicsScene::updateTexture() {
-    System::Device()->waitIdle();
+    STALL_SITE("GraphicsScene::updateTexture");
     VECTOR<STRING> pbrPaths = System::Files()->getTexturePBRPaths();
+    DeletionQueue* pDeletionQueue = System::DeletionQueue();
     bool hasImage = m_pTextures.size() > 0;
+    uint setIdx = hasImage ? (m_textureSetIdx + 1) % TEXTURE_SET_COUNT : 0;
+    waitSetIdle(m_textureSetValues, setIdx);
+    
+    if (!hasImage) m_cleaner.push([=](){ for (Image* pTexture : m_pTextures) pTexture->cleanup(); });
     m_pTextures.resize(pbrPaths.size());
     for (uint i = 0; i < pbrPaths.size(); i++) {
-        if (hasImage) m_pTextures[i]->cleanup();
+        Image* pRetired = m_pTextures[i];
+        if (hasImage) pDeletionQueue->retire([=](){ pRetired->cleanup(); });
         m_pTextures[i] = new Image();
         m_pTextures[i]->setupForTexture(pbrPaths[i]);
         m_pTextures[i]->createWithSampler();
         m_pTextures[i]->cmdCopyRawDataToImage();
         m_pTextures[i]->cmdTransitionToShaderR();
-        m_cleaner.push([=](){ m_pTextures[i]->cleanup(); });
-        m_pDescriptor->setupPointerImage(S2, i, m_pTextures[i]->getDescriptorInfo());
+        m_pDescriptor->setupPointerImage(S2, setIdx, i, m_pTextures[i]->getDescriptorInfo());
     }
     m_pDescriptor->update(S2);
+    m_textureSetIdx = setIdx;
 }
 
-void GraphicsScene::updateCubemap(Image* cubemap, Image* envMap, Image* reflMap, Image* brdfMap) {
+// Images are expected in shader read layout. The new set is written to the idle
+// descriptor set so frames still in flight keep sampling the previous environment.
+void GraphicsScene::updateCubemap(Image* cubemap, Irradiance* pIrradiance, Image* reflMap, Image* brdfMap) {
+    STALL_SITE("GraphicsScene::updateCubemap");
+    uint setIdx = (m_cubemapSetIdx + 1) % CUBEMAP_SET_COUNT;
+    waitSetIdle(m_cubemapSetValues, setIdx);
     m_pCubemap = cubemap;
-    m_pEnvMap = envMap;
     m_pReflMap = reflMap;
     m_pBrdfMap = brdfMap;
-    m_pCubemap->cmdTransitionToShaderR();
-    m_pEnvMap->cmdTransitionToShaderR();
-    m_pReflMap->cmdTransitionToShaderR();
-    m_pBrdfMap->cmdTransitionToShaderR();
-    m_pDescriptor->setupPointerImage(S5, B0, m_pCubemap->getDescriptorInfo());
-    m_pDescriptor->setupPointerImage(S5, B1, m_pEnvMap->getDescriptorInfo());
-    m_pDescriptor->setupPointerImage(S5, B2, m_pReflMap->getDescriptorInfo());
-    m_pDescriptor->setupPointerImage(S5, B3, m_pBrdfMap->getDescriptorInfo());
+    memcpy(m_irradiance.coefficients, pIrradiance->getCoefficients(), sizeof(UBIrradiance));
+    m_pIrradianceBuffers[setIdx]->fillBuffer(&m_irradiance, sizeof(UBIrradiance));
+    m_pDescriptor->setupPointerImage(S5, setIdx, B0, m_pCubemap->getDescriptorInfo());
+    m_pDescriptor->setupPointerBuffer(S5, setIdx, B1, m_pIrradianceBuffers[setIdx]->getDescriptorInfo());
+    m_pDescriptor->setupPointerImage(S5, setIdx, B2, m_pReflMap->getDescriptorInfo());
+    m_pDescriptor->setupPointerImage(S5, setIdx, B3, m_pBrdfMap->getDescriptorInfo());
     m_pDescriptor->update(S5);
-    m_cleaner.push([=](){ m_pCubemap->cleanup(); });
-    m_cleaner.push([=](){ m_pEnvMap->cleanup(); });
-    m_cleaner.push([=](){ m_pReflMap->cleanup(); });
-    m_cleaner.push([=](){ m_pBrdfMap->cleanup(); });
+    m_cubemapSetIdx = setIdx;
+    m_pSkyboxCommands->invalidate();
+}
+
+// A set about to be rewritten may not be bound by a frame still in flight. The
+// previously current set is stamped with the last graphic submit that used it.
+void GraphicsScene::waitSetIdle(VECTOR<uint64_t>& setValues, uint setIdx) {
+    Timeline* pTimeline = m_pDevice->getGraphicTimeline();
+    uint64_t  value     = pTimeline->getLastValue();
+    pTimeline->wait(setValues[setIdx]);
+    setValues[(setIdx + 1) % setValues.size()] = value;
 }
 
 void GraphicsScene::updateLightInput() {
@@ -221,7 +320,6 @@ void GraphicsScene::updateLightInput() {
         m_lights.position[i].x = sin(m_iteration / 100.f + i * interval) * distance.y;
         m_lights.position[i].y = cos(m_iteration / 100.f + i * interval) * distance.y;
     }
-    m_pLightBuffer->fillBuffer(&m_lights, sizeof(UBLights));
 }
 
 void GraphicsScene::updateParamInput() {
@@ -239,7 +337,6 @@ void GraphicsScene::updateParamInput() {
     m_param.reflectanceValue = settings->ReflectanceValue;
     m_param.opdOffset        = settings->OPDOffset;
     m_param.opdSample        = settings->OPDSample;
-    m_pParamBuffer->fillBuffer(&m_param, sizeof(UBParam));
 }
 
 void GraphicsScene::updateCameraInput(Camera* pCamera) {
@@ -247,16 +344,29 @@ void GraphicsScene::updateCameraInput(Camera* pCamera) {
     m_misc.viewPosition = pCamera->getPosition();
     m_camera.view = pCamera->getViewMatrix();
     m_camera.proj = pCamera->getProjection((float) size.width / size.height);
-    m_pCameraBuffer->fillBuffer(&m_camera, sizeof(UBCamera));
 }
 
-void GraphicsScene::updateHeightmapInput(Image *pHeightmapImage) {
-    m_pHeightmap = pHeightmapImage;
-    m_pHeightmap->cmdTransitionToShaderR();
-    m_pDescriptor->setupPointerImage(S3, B0, m_pHeightmap->getDescriptorInfo());
-    m_pDescriptor->update(S3);
+// Uniforms are written to the buffers of the frame in flight about to be
+// recorded, whose previous submission has already been waited on.
+void GraphicsScene::setFrameIdx(uint frameIdx) {
+    m_frameIdx = frameIdx;
+    m_pCameraBuffers[frameIdx]->fillBuffer(&m_camera, sizeof(UBCamera));
+    m_pLightBuffers[frameIdx]->fillBuffer(&m_lights, sizeof(UBLights));
+    m_pParamBuffers[frameIdx]->fillBuffer(&m_param, sizeof(UBParam));
+}
+
+// One set per simulation slot, the one bound follows the slot graphics reads
+void GraphicsScene::updateHeightmapInput(VECTOR<Image*> pHeightmapImages) {
+    m_pHeightmaps = pHeightmapImages;
+    for (uint i = 0; i < m_pHeightmaps.size(); i++) {
+        m_pHeightmaps[i]->cmdTransitionToShaderR();
+        m_pDescriptor->setupPointerImage(S3, i, B0, m_pHeightmaps[i]->getDescriptorInfo());
+        m_pDescriptor->update(S3);
+    }
 }
 
+void GraphicsScene::setSimulationSlot(uint slot) { m_simulationSlot = slot; }
+
 void GraphicsScene::updateInterferenceInput(Image* pInterferenceImage) {
     m_pInterference = pInterferenceImage;
     m_pInterference->cmdTransitionToShaderR();
@@ -265,6 +375,7 @@ void GraphicsScene::updateInterferenceInput(Image* pInterferenceImage) {
     uint bufferSize = m_pInterference->getImageSize().width * sizeof(float);
     m_pMarkBuffer = new Buffer();
     m_pMarkBuffer->setup(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    m_pMarkBuffer->setMemoryTag(MEMORY_TAG_SIM);
     m_pMarkBuffer->create();
     m_cleaner.push([=](){ m_pMarkBuffer->cleanup(); });
     
@@ -276,65 +387,72 @@ void GraphicsScene::updateInterferenceInput(Image* pInterferenceImage) {
 void GraphicsScene::createDescriptor() {
     LOG("GraphicsScene::createDescriptor");
     m_pDescriptor = new Descriptor();
-    m_pDescriptor->setupLayout(S0);
-    m_pDescriptor->addLayoutBindings(S0, B0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                                     VK_SHADER_STAGE_VERTEX_BIT);
-    m_pDescriptor->createLayout(S0);
-    
-    m_pDescriptor->setupLayout(S1);
-    m_pDescriptor->addLayoutBindings(S1, B0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                                     VK_SHADER_STAGE_FRAGMENT_BIT);
-    m_pDescriptor->addLayoutBindings(S1, B1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                                     VK_SHADER_STAGE_FRAGMENT_BIT);
-    m_pDescriptor->createLayout(S1);
-    
-    m_pDescriptor->setupLayout(S2);
+    SetupDescriptorLayouts(m_pDescriptor);
+    for (uint set : {S0, S1, S2, S3, S4, S5})
+        m_pDescriptor->createLayout(set);
+    
+    m_pDescriptor->createPool();
+    m_pDescriptor->allocate(S0);
+    m_pDescriptor->allocate(S1);
+    m_pDescriptor->allocate(S2);
+    m_pDescriptor->allocate(S3);
+    m_pDescriptor->allocate(S4);
+    m_pDescriptor->allocate(S5);
+    m_cleaner.push([=](){ m_pDescriptor->cleanup(); });
+}
+
+// Only records the layouts and pool sizes, so the microbenchmark times it
+// without a device
+void GraphicsScene::SetupDescriptorLayouts(Descriptor* pDescriptor) {
+    pDescriptor->setupLayout(S0, MAX_FRAMES_IN_FLIGHT);
+    pDescriptor->addLayoutBindings(S0, B0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                   VK_SHADER_STAGE_VERTEX_BIT);
+    
+    pDescriptor->setupLayout(S1, MAX_FRAMES_IN_FLIGHT);
+    pDescriptor->addLayoutBindings(S1, B0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                   VK_SHADER_STAGE_FRAGMENT_BIT);
+    pDescriptor->addLayoutBindings(S1, B1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                   VK_SHADER_STAGE_FRAGMENT_BIT);
+    
+    pDescriptor->setupLayout(S2, TEXTURE_SET_COUNT);
     for (uint i = 0; i < 5; i++) {
-        m_pDescriptor->addLayoutBindings(S2, i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        pDescriptor->addLayoutBindings(S2, i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                                        VK_SHADER_STAGE_FRAGMENT_BIT);
     }
-    m_pDescriptor->createLayout(S2);
     
-    m_pDescriptor->setupLayout(S3);
-    m_pDescriptor->addLayoutBindings(S3, B0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    pDescriptor->setupLayout(S3, SIMULATION_SLOT_COUNT);
+    pDescriptor->addLayoutBindings(S3, B0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                                    VK_SHADER_STAGE_FRAGMENT_BIT);
-    m_pDescriptor->createLayout(S3);
     
-    m_pDescriptor->setupLayout(S4);
-    m_pDescriptor->addLayoutBindings(S4, B0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    pDescriptor->setupLayout(S4);
+    pDescriptor->addLayoutBindings(S4, B0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                                    VK_SHADER_STAGE_FRAGMENT_BIT);
-    m_pDescriptor->addLayoutBindings(S4, B1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    pDescriptor->addLayoutBindings(S4, B1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                                    VK_SHADER_STAGE_FRAGMENT_BIT);
-    m_pDescriptor->createLayout(S4);
     
-    m_pDescriptor->setupLayout(S5);
-    m_pDescriptor->addLayoutBindings(S5, B0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    pDescriptor->setupLayout(S5, CUBEMAP_SET_COUNT);
+    pDescriptor->addLayoutBindings(S5, B0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                                    VK_SHADER_STAGE_FRAGMENT_BIT);
-    m_pDescriptor->addLayoutBindings(S5, B1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    pDescriptor->addLayoutBindings(S5, B1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
                                    VK_SHADER_STAGE_FRAGMENT_BIT);
-    m_pDescriptor->addLayoutBindings(S5, B2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    pDescriptor->addLayoutBindings(S5, B2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                                    VK_SHADER_STAGE_FRAGMENT_BIT);
-    m_pDescriptor->addLayoutBindings(S5, B3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    pDescriptor->addLayoutBindings(S5, B3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                                    VK_SHADER_STAGE_FRAGMENT_BIT);
-    m_pDescriptor->createLayout(S5);
-    
-    m_pDescriptor->createPool();
-    m_pDescriptor->allocate(S0);
-    m_pDescriptor->allocate(S1);
-    m_pDescriptor->allocate(S2);
-    m_pDescriptor->allocate(S3);
-    m_pDescriptor->allocate(S4);
-    m_pDescriptor->allocate(S5);
-    m_cleaner.push([=](){ m_pDescriptor->cleanup(); });
 }
 
 void GraphicsScene::createRenderpass() {
     m_pRenderpass = new Renderpass();
-    m_pRenderpass->setupColorAttachment();
+    m_pRenderpass->setupColorAttachment(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
     m_pRenderpass->setupDepthAttachment();
     m_pRenderpass->setup();
     m_pRenderpass->create();
     m_cleaner.push([=](){ m_pRenderpass->cleanup(); });
+    
+    m_pSkyboxCommands = new StaticCommands();
+    m_pSkyboxCommands->setup(m_pRenderpass->get(), MAX_FRAMES_IN_FLIGHT);
+    m_pSkyboxCommands->create();
+    m_cleaner.push([=](){ m_pSkyboxCommands->cleanup(); });
 }
 
 void GraphicsScene::createPipelineLayout() {
@@ -418,8 +536,9 @@ void GraphicsScene::createPipeline() {
 void GraphicsScene::createFrame(UInt2D size) {
     LOG("GraphicsScene::createFrame");
     m_pFrame = new Frame(size);
-    m_pFrame->createImageResource();
-    m_pFrame->createDepthResource();
+    createTargets(size);
+    m_pFrame->createImageResource(m_pColorImage);
+    m_pFrame->createDepthResource(m_pDepthImage);
     m_pFrame->createFramebuffer(m_pRenderpass);
     m_cleaner.push([=](){ m_pFrame->cleanup(); });
     updateViewportScissor();
@@ -428,11 +547,28 @@ void GraphicsScene::createFrame(UInt2D size) {
 void GraphicsScene::recreateFrame(UInt2D size) {
     LOG("GraphicsScene::recreateFrame");
     m_pFrame->cleanup();
+    m_pRenderGraph->releaseTransients();
     m_pFrame->setSize(size);
-    m_pFrame->createImageResource();
-    m_pFrame->createDepthResource();
+    createTargets(size);
+    m_pFrame->createImageResource(m_pColorImage);
+    m_pFrame->createDepthResource(m_pDepthImage);
     m_pFrame->createFramebuffer(m_pRenderpass);
     updateViewportScissor();
+    m_pSkyboxCommands->invalidate();
+}
+
+// The targets are transients of the render graph, placed in its aliased pool
+void GraphicsScene::createTargets(UInt2D size) {
+    RenderGraph* pGraph = m_pRenderGraph;
+    
+    m_pColorImage = new Image();
+    m_pColorImage->setupForColor(size);
+    m_pDepthImage = new Image();
+    m_pDepthImage->setupForDepth(size);
+    
+    pGraph->addTransient(m_pColorImage, "scene", "screen");
+    pGraph->addTransient(m_pDepthImage, "scene", "scene");
+    pGraph->createTransients();
 }
 
 void GraphicsScene::updateViewportScissor() {
@@ -8,10 +8,14 @@
 #include "../renderer/pipeline.hpp"
 #include "../renderer/renderpass.hpp"
 #include "../renderer/descriptor.hpp"
+#include "../renderer/render_graph.hpp"
+#include "../renderer/recorder.hpp"
+#include "../renderer/static_commands.hpp"
 #include "../resources/buffer.hpp"
 #include "../resources/frame.hpp"
 #include "../resources/mesh.hpp"
 #include "../resources/camera.hpp"
+#include "../resources/irradiance.hpp"
 
 
 class GraphicsScene {
@@ -51,6 +55,10 @@ class GraphicsScene {
         uint  opdSample        = 16384;
     };
     
+    struct UBIrradiance {
+        glm::vec4 coefficients[SH_COEFFICIENTS];
+    };
+    
     
 public:
     ~GraphicsScene();
@@ -58,18 +66,25 @@ public:
     
     void cleanup();
     void render(VkCommandBuffer cmdBuffer);
+    void recordAsync(Recorder* pRecorder);
+    void clearMarkBuffer(VkCommandBuffer cmdBuffer);
+    void addPasses(RenderGraph* pGraph);
     
     void setupShader();
     void setupInput();
+    void setupRenderGraph(RenderGraph* pGraph);
     void updateTexture();
-    void updateCubemap(Image* cubemap, Image* envMap, Image* reflMap, Image* brdfMap);
+    void updateCubemap(Image* cubemap, Irradiance* pIrradiance, Image* reflMap, Image* brdfMap);
     void updateLightInput();
     void updateParamInput();
     void updateCameraInput(Camera* pCamera);
+    void setFrameIdx(uint frameIdx);
     void updateInterferenceInput(Image* pInterferenceImage);
-    void updateHeightmapInput(Image* pHeightmapImage);
+    void updateHeightmapInput(VECTOR<Image*> pHeightmapImages);
+    void setSimulationSlot(uint slot);
     
     void createDescriptor();
+    static void SetupDescriptorLayouts(Descriptor* pDescriptor);
     void createPipelineLayout();
     void createPipeline();
     void createRenderpass();
@@ -87,20 +102,26 @@ private:
     Pipeline* m_pCubemapPipeline;
     Renderpass* m_pRenderpass;
     Descriptor* m_pDescriptor;
-    
-    Buffer* m_pLightBuffer;
-    Buffer* m_pParamBuffer;
-    Buffer* m_pCameraBuffer;
+    RenderGraph* m_pRenderGraph;
+    Recorder*    m_pRecorder;
+    uint         m_drawJob = 0;
+    StaticCommands* m_pSkyboxCommands;
+    
+    VECTOR<Buffer*> m_pLightBuffers;
+    VECTOR<Buffer*> m_pParamBuffers;
+    VECTOR<Buffer*> m_pCameraBuffers;
+    VECTOR<Buffer*> m_pIrradianceBuffers;
     Buffer* m_pMarkBuffer;
     Frame*  m_pFrame;
+    Image*  m_pColorImage;
+    Image*  m_pDepthImage;
     
     Mesh*   m_pCube;
     VECTOR<Mesh*> m_pMesh;
     Image*  m_pCubemap;
-    Image*  m_pEnvMap;
     Image*  m_pReflMap;
     Image*  m_pBrdfMap;
-    Image*  m_pHeightmap;
+    VECTOR<Image*> m_pHeightmaps;
     Image*  m_pInterference;
     VECTOR<Image*> m_pTextures;
     
@@ -108,11 +129,18 @@ private:
     UBLights m_lights{};
     UBCamera m_camera{};
     UBParam  m_param{};
+    UBIrradiance m_irradiance{};
     
     VkViewport m_viewport{};
     VkRect2D   m_scissor{};
     
     uint m_textureIdx = 6; // 3,4,
+    uint m_cubemapSetIdx = 0;
+    uint m_textureSetIdx = 0;
+    VECTOR<uint64_t> m_cubemapSetValues;
+    VECTOR<uint64_t> m_textureSetValues;
+    uint m_simulationSlot = 0;
+    uint m_frameIdx = 0;
     long m_iteration = 0;
     
     VkPipelineLayout m_pipelineLayout;
@@ -120,6 +148,10 @@ private:
     VkPushConstantRange m_pushConstantRange;
     VECTOR<VkPipelineShaderStageCreateInfo> m_shaderStages;
     
+    void recordSkybox(VkCommandBuffer cmdBuffer);
+    void recordDraws (VkCommandBuffer cmdBuffer);
+    void waitSetIdle(VECTOR<uint64_t>& setValues, uint setIdx);
+    void createTargets(UInt2D size);
     void updateViewportScissor();
     
 };
@@ -12,16 +12,12 @@ GraphicsScreen::GraphicsScreen() : m_pDevice(System::Device()) {}
 
 void GraphicsScreen::cleanup() { m_cleaner.flush("GraphicsScreen"); }
 
-void GraphicsScreen::render(VkCommandBuffer cmdBuffer, GUI* pGUI) {
-    Image*           pInputImage    = m_pInputFrame->getColorImage();;
-    VkPipelineLayout pipelineLayout = m_pipelineLayout;
-    VkPipeline       pipeline       = m_pPipeline->get();
+// The GUI was recorded on a worker and the quad is replayed from its static
+// recording, the primary only runs the render pass
+void GraphicsScreen::render(VkCommandBuffer cmdBuffer) {
     VkRenderPass     renderpass     = m_pRenderpass->get();
     VkFramebuffer    framebuffer    = m_pFrame->getFramebuffer();
     VkRect2D         scissor        = m_scissor;
-    VkViewport       viewport       = m_viewport;
-    
-    VkDescriptorSet textureDescSet = m_pDescriptor->getDescriptorSet(S0);
     
     std::array<VkClearValue, 2> clearValues{};
     clearValues[0].color = {0.1f, 0.1f, 0.1f, 1.0f};
@@ -35,24 +31,52 @@ void GraphicsScreen::render(VkCommandBuffer cmdBuffer, GUI* pGUI) {
     renderBeginInfo.framebuffer     = framebuffer;
     renderBeginInfo.renderArea      = scissor;
     
-    pInputImage->cmdTransitionToShaderR(cmdBuffer);
+    std::array<VkCommandBuffer, 2> drawBuffers{};
+    drawBuffers[0] = m_pQuadCommands->get(m_frameIdx, [=](VkCommandBuffer quadBuffer){
+        recordQuad(quadBuffer);
+    });
+    drawBuffers[1] = m_pRecorder->wait(m_drawJob);
     
-    vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
-    vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
-    
-    vkCmdBeginRenderPass(cmdBuffer, &renderBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-    
-    vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            pipelineLayout, S0, 1, &textureDescSet, 0, nullptr);
+    vkCmdBeginRenderPass(cmdBuffer, &renderBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(cmdBuffer, UINT32(drawBuffers.size()), drawBuffers.data());
+    vkCmdEndRenderPass(cmdBuffer);
+}
 
-    vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-    vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
-    
-    pGUI->renderGUI(cmdBuffer);
+// Starts recording the GUI into a secondary buffer, ImGui sets its own
+// viewport and scissor. Its timing scope is reserved here, the worker only
+// writes the timestamps. Headless runs have no GUI, the buffer stays empty.
+void GraphicsScreen::recordAsync(Recorder* pRecorder, GUI* pGUI, GPUProfiler* pProfiler) {
+    VkRenderPass  renderpass  = m_pRenderpass->get();
+    VkFramebuffer framebuffer = m_pFrame->getFramebuffer();
+    
+    m_pGUI      = pGUI;
+    m_pProfiler = pProfiler;
+    m_guiScope  = pProfiler->addScope("gui");
+    m_pRecorder = pRecorder;
+    m_drawJob   = pRecorder->record(renderpass, framebuffer,
+                                    [=](VkCommandBuffer cmdBuffer){ recordGUI(cmdBuffer); });
+}
+
+void GraphicsScreen::recordGUI(VkCommandBuffer cmdBuffer) {
+    GUI*         pGUI      = m_pGUI;
+    GPUProfiler* pProfiler = m_pProfiler;
+    uint         scope     = m_guiScope;
     
-    vkCmdEndRenderPass(cmdBuffer);
+    pProfiler->cmdBegin(cmdBuffer, scope);
+    if (pGUI) pGUI->renderGUI(cmdBuffer);
+    pProfiler->cmdEnd(cmdBuffer, scope);
+}
+
+// Draws to the swapchain, so the pass is a root. The returned index lets the
+// caller declare what the GUI samples.
+uint GraphicsScreen::addPass(RenderGraph* pGraph) {
+    Image* pInputImage = m_pInputFrame->getColorImage();
     
-    pInputImage->cmdTransitionToPresent(cmdBuffer);
+    uint pass = pGraph->addPass("screen", [=](VkCommandBuffer cmdBuffer){ render(cmdBuffer); });
+    pGraph->setRoot(pass);
+    pGraph->readImage(pass, pInputImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                      VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    return pass;
 }
 
 void GraphicsScreen::setupShader() {
@@ -69,8 +93,8 @@ void GraphicsScreen::setupInput(Frame* pFrame) {
     pImage->cmdTransitionToShaderR();
     m_pDescriptor->setupPointerImage(S0, B0, pImage->getDescriptorInfo());
     m_pDescriptor->update(S0);
-    pImage->cmdTransitionToPresent();
     m_pInputFrame = pFrame;
+    m_pQuadCommands->invalidate();
 }
 
 void GraphicsScreen::createDescriptor() {
@@ -89,11 +113,18 @@ void GraphicsScreen::createDescriptor() {
 void GraphicsScreen::createRenderpass() {
     LOG("GraphicsScreen::createRenderpass");
     VkSurfaceFormatKHR surfaceFormat = m_pDevice->getSurfaceFormat();
+    VkImageLayout      finalLayout   = m_pDevice->isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                                               : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
     m_pRenderpass = new Renderpass();
-    m_pRenderpass->setupColorAttachment(surfaceFormat.format);
+    m_pRenderpass->setupColorAttachment(surfaceFormat.format, finalLayout);
     m_pRenderpass->setup();
     m_pRenderpass->create();
     m_cleaner.push([=](){ m_pRenderpass->cleanup(); });
+    
+    m_pQuadCommands = new StaticCommands();
+    m_pQuadCommands->setup(m_pRenderpass->get(), MAX_FRAMES_IN_FLIGHT);
+    m_pQuadCommands->create();
+    m_cleaner.push([=](){ m_pQuadCommands->cleanup(); });
 }
 
 void GraphicsScreen::createPipelineLayout() {
@@ -138,6 +169,26 @@ void GraphicsScreen::createPipeline() {
     m_cleaner.push([=](){ m_pPipeline->cleanup(); });
 }
 
+// Viewport and scissor are not inherited, the secondary sets its own. The quad
+// only changes with the input frame and the swapchain size.
+void GraphicsScreen::recordQuad(VkCommandBuffer cmdBuffer) {
+    VkPipelineLayout pipelineLayout = m_pipelineLayout;
+    VkPipeline       pipeline       = m_pPipeline->get();
+    VkRect2D         scissor        = m_scissor;
+    VkViewport       viewport       = m_viewport;
+    
+    VkDescriptorSet textureDescSet = m_pDescriptor->getDescriptorSet(S0);
+    
+    vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
+    
+    vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            pipelineLayout, S0, 1, &textureDescSet, 0, nullptr);
+    
+    vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
+}
+
 void GraphicsScreen::updateViewportScissor() {
     UInt2D extent = m_pFrame->getSize();
     m_viewport.x = 0.f;
@@ -150,7 +201,19 @@ void GraphicsScreen::updateViewportScissor() {
     m_scissor.extent = extent;
 }
 
-void GraphicsScreen::setFrame(Frame *pFrame) { m_pFrame = pFrame;  updateViewportScissor(); }
+// Frames cycle through the swapchain images, the quad is only recorded again
+// when their size changes
+void GraphicsScreen::setFrame(Frame *pFrame, uint frameIdx) {
+    UInt2D size   = pFrame->getSize();
+    UInt2D extent = m_scissor.extent;
+    bool resized = size.width != extent.width || size.height != extent.height;
+    m_pFrame   = pFrame;
+    m_frameIdx = frameIdx;
+    if (!resized) return;
+    
+    updateViewportScissor();
+    m_pQuadCommands->invalidate();
+}
 
 Renderpass* GraphicsScreen::getRenderpass() { return m_pRenderpass; }
 
@@ -8,6 +8,10 @@
 #include "../renderer/pipeline.hpp"
 #include "../renderer/renderpass.hpp"
 #include "../renderer/descriptor.hpp"
+#include "../renderer/render_graph.hpp"
+#include "../renderer/recorder.hpp"
+#include "../renderer/static_commands.hpp"
+#include "../renderer/gpu_profiler.hpp"
 #include "../resources/frame.hpp"
 #include "../resources/image.hpp"
 #include "../window/gui.hpp"
@@ -20,7 +24,9 @@ public:
     GraphicsScreen();
     
     void cleanup();
-    void render(VkCommandBuffer cmdBuffer, GUI* pGUI);
+    void render(VkCommandBuffer cmdBuffer);
+    void recordAsync(Recorder* pRecorder, GUI* pGUI, GPUProfiler* pProfiler);
+    uint addPass(RenderGraph* pGraph);
     
     void setupShader();
     void setupInput(Frame* pFrame);
@@ -30,7 +36,7 @@ public:
     void createPipeline();
     void createRenderpass();
     
-    void setFrame(Frame* pFrame);
+    void setFrame(Frame* pFrame, uint frameIdx);
     
     Renderpass* getRenderpass();
     
@@ -40,9 +46,18 @@ private:
     Pipeline* m_pPipeline;
     Renderpass* m_pRenderpass;
     Descriptor* m_pDescriptor;
+    Recorder* m_pRecorder;
+    uint      m_drawJob = 0;
+    StaticCommands* m_pQuadCommands;
+    
+    // Read by the draw job, which then only captures the screen
+    GUI*         m_pGUI      = nullptr;
+    GPUProfiler* m_pProfiler = nullptr;
+    uint         m_guiScope  = PROFILER_NO_SCOPE;
     
     Frame* m_pInputFrame;
     Frame* m_pFrame;
+    uint   m_frameIdx = 0;
     
     VkViewport m_viewport{};
     VkRect2D   m_scissor{};
@@ -51,6 +66,8 @@ private:
     
     VECTOR<VkPipelineShaderStageCreateInfo> m_shaderStages;
   
+    void recordQuad(VkCommandBuffer cmdBuffer);
+    void recordGUI (VkCommandBuffer cmdBuffer);
     void updateViewportScissor();
     
 };
@@ -0,0 +1,127 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "ibl_baker.hpp"
+
+#include "../system.hpp"
+
+IBLBaker::~IBLBaker() {}
+IBLBaker::IBLBaker() {}
+
+void IBLBaker::cleanup() { m_cleaner.flush("IBLBaker"); }
+
+void IBLBaker::setup(uint32_t cubeLength, UInt2D brdfSize) {
+    LOG("IBLBaker::setup");
+    m_cubeLength = cubeLength;
+    m_pArena = new ScratchArena();
+    m_pArena->setMemoryTag(MEMORY_TAG_IBL);
+    m_cleaner.push([=](){ m_pArena->cleanup(); });
+    createComputeHDR();
+    createGraphicsEquirect();
+    createGraphicsReflection();
+    createComputeBRDF(brdfSize);
+}
+
+// The returned cubemap and reflection map are new images owned by the caller,
+// every intermediate image is released back to the arena before returning.
+void IBLBaker::bake(std::string hdrPath, Irradiance* pIrradiance) {
+    LOG("IBLBaker::bake");
+    ScratchArena*       pArena              = m_pArena;
+    ComputeHDR*         pComputeHDR         = m_pComputeHDR;
+    GraphicsEquirect*   pGraphicsEquirect   = m_pGraphicsEquirect;
+    GraphicsReflection* pGraphicsReflection = m_pGraphicsReflection;
+    UInt2D              cubeSize            = {m_cubeLength, m_cubeLength};
+    Commander*          pCommander          = System::Commander();
+    
+    Image* pStorageImage = new Image();
+    pStorageImage->setupForHDRTexture(hdrPath);
+    pStorageImage->setMipLevels(1);
+    Image* pTextureImage = new Image();
+    pTextureImage->setupForHDRTexture(pStorageImage->getImageSize());
+    Image* pEquirectTarget = new Image();
+    pEquirectTarget->setupForCubeTarget(cubeSize);
+    Image* pReflectionTarget = new Image();
+    pReflectionTarget->setupForCubeTarget(cubeSize);
+    
+    pArena->addImage(pStorageImage,     BAKE_STAGE_HDR,        BAKE_STAGE_HDR);
+    pArena->addImage(pTextureImage,     BAKE_STAGE_HDR,        BAKE_STAGE_EQUIRECT);
+    pArena->addImage(pEquirectTarget,   BAKE_STAGE_EQUIRECT,   BAKE_STAGE_EQUIRECT);
+    pArena->addImage(pReflectionTarget, BAKE_STAGE_REFLECTION, BAKE_STAGE_REFLECTION);
+    pArena->create();
+    
+    pCommander->beginProfileScope("bake hdr");
+    pComputeHDR->setupInputOutput(pStorageImage, pTextureImage);
+    pComputeHDR->dispatch();
+    pIrradiance->projectEquirect(pStorageImage);
+    pComputeHDR->cleanInputOutput();
+    pCommander->endProfileScope();
+    
+    pCommander->beginProfileScope("bake equirect");
+    pGraphicsEquirect->setupInput(pTextureImage);
+    pGraphicsEquirect->createFrame(pEquirectTarget);
+    m_pCubemap = pGraphicsEquirect->render();
+    pGraphicsEquirect->cleanFrame();
+    pCommander->endProfileScope();
+    
+    pCommander->beginProfileScope("bake reflection");
+    pGraphicsReflection->setupInput(m_pCubemap);
+    pGraphicsReflection->createFrame(pReflectionTarget);
+    m_pReflMap = pGraphicsReflection->render();
+    pGraphicsReflection->cleanFrame();
+    pCommander->endProfileScope();
+    
+    pArena->release();
+    
+    m_pCubemap->cmdTransitionToShaderR();
+    m_pReflMap->cmdTransitionToShaderR();
+}
+
+Image* IBLBaker::getCubemap()       { return m_pCubemap; }
+Image* IBLBaker::getReflectionMap() { return m_pReflMap; }
+Image* IBLBaker::getBRDFMap()       { return m_pBrdfMap; }
+
+// Private ==================================================
+
+void IBLBaker::createComputeHDR() {
+    m_pComputeHDR = new ComputeHDR();
+    m_pComputeHDR->setupShader();
+    m_pComputeHDR->createDescriptor();
+    m_pComputeHDR->createPipelineLayout();
+    m_pComputeHDR->createPipeline();
+    m_cleaner.push([=](){ m_pComputeHDR->cleanup(); });
+}
+
+void IBLBaker::createGraphicsEquirect() {
+    m_pGraphicsEquirect = new GraphicsEquirect();
+    m_pGraphicsEquirect->setupShader();
+    m_pGraphicsEquirect->createDescriptor();
+    m_pGraphicsEquirect->setupMesh();
+    m_pGraphicsEquirect->createRenderpass();
+    m_pGraphicsEquirect->createPipelineLayout();
+    m_pGraphicsEquirect->createPipeline();
+    m_cleaner.push([=](){ m_pGraphicsEquirect->cleanup(); });
+}
+
+void IBLBaker::createGraphicsReflection() {
+    m_pGraphicsReflection = new GraphicsReflection();
+    m_pGraphicsReflection->setupShader();
+    m_pGraphicsReflection->createDescriptor();
+    m_pGraphicsReflection->setupMesh();
+    m_pGraphicsReflection->createRenderpass();
+    m_pGraphicsReflection->createPipelineLayout();
+    m_pGraphicsReflection->createPipeline();
+    m_cleaner.push([=](){ m_pGraphicsReflection->cleanup(); });
+}
+
+// The BRDF lookup does not depend on the environment, so it is baked once.
+void IBLBaker::createComputeBRDF(UInt2D size) {
+    m_pComputeBRDF = new ComputeBRDF();
+    m_pComputeBRDF->setupShader();
+    m_pComputeBRDF->createDescriptor();
+    m_pComputeBRDF->createPipelineLayout();
+    m_pComputeBRDF->createPipeline();
+    System::Commander()->beginProfileScope("bake brdf");
+    m_pBrdfMap = m_pComputeBRDF->dispatch(size);
+    System::Commander()->endProfileScope();
+    m_cleaner.push([=](){ m_pComputeBRDF->cleanup(); m_pBrdfMap->cleanup(); });
+}
@@ -0,0 +1,57 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "../resources/image.hpp"
+#include "../resources/irradiance.hpp"
+#include "../resources/scratch_arena.hpp"
+#include "compute_hdr.hpp"
+#include "compute_brdf.hpp"
+#include "graphics_equirect.hpp"
+#include "graphics_reflection.hpp"
+
+// Owns the image based lighting bake pipelines so switching environments only
+// rebinds inputs and records the GPU work. Intermediate images live in a
+// scratch arena aliased across the bake stages.
+class IBLBaker {
+    
+    enum BakeStage {
+        BAKE_STAGE_HDR,
+        BAKE_STAGE_EQUIRECT,
+        BAKE_STAGE_REFLECTION
+    };
+    
+public:
+    ~IBLBaker();
+    IBLBaker();
+    
+    void cleanup();
+    void setup(uint32_t cubeLength, UInt2D brdfSize);
+    void bake(std::string hdrPath, Irradiance* pIrradiance);
+    
+    Image* getCubemap();
+    Image* getReflectionMap();
+    Image* getBRDFMap();
+    
+private:
+    Cleaner m_cleaner;
+    ComputeHDR*         m_pComputeHDR;
+    ComputeBRDF*        m_pComputeBRDF;
+    GraphicsEquirect*   m_pGraphicsEquirect;
+    GraphicsReflection* m_pGraphicsReflection;
+    ScratchArena*       m_pArena;
+    
+    uint32_t m_cubeLength;
+    
+    Image* m_pCubemap;
+    Image* m_pReflMap;
+    Image* m_pBrdfMap;
+    
+    void createComputeHDR();
+    void createComputeBRDF(UInt2D size);
+    void createGraphicsEquirect();
+    void createGraphicsReflection();
+    
+};
@@ -0,0 +1,93 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "async_compute.hpp"
+
+#include "../system.hpp"
+
+AsyncCompute::~AsyncCompute() {}
+AsyncCompute::AsyncCompute() : m_pDevice(System::Device()) {}
+
+void AsyncCompute::cleanup() { m_cleaner.flush("AsyncCompute"); }
+
+void AsyncCompute::setup() {
+    m_pTimeline        = m_pDevice->getComputeTimeline();
+    m_queueFamilyIndex = m_pDevice->getComputeQueueIndex();
+    m_frameValues.resize(MAX_FRAMES_IN_FLIGHT, 0);
+    m_writeValues.resize(SIMULATION_SLOT_COUNT, 0);
+    m_readValues .resize(SIMULATION_SLOT_COUNT, 0);
+}
+
+// One transient pool per frame in flight, reset as a whole before the
+// frame's buffer is recorded again
+void AsyncCompute::create() {
+    LOG("AsyncCompute::create");
+    VkDevice device = m_pDevice->getDevice();
+    
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = m_queueFamilyIndex;
+    
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    
+    m_commandPools  .resize(MAX_FRAMES_IN_FLIGHT);
+    m_commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    for (uint i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkResult result = vkCreateCommandPool(device, &poolInfo, nullptr, &m_commandPools[i]);
+        CHECK_VKRESULT(result, "failed to create compute command pool!");
+        m_cleaner.push([=](){ vkDestroyCommandPool(device, m_commandPools[i], nullptr); });
+        
+        allocInfo.commandPool = m_commandPools[i];
+        result = vkAllocateCommandBuffers(device, &allocInfo, &m_commandBuffers[i]);
+        CHECK_VKRESULT(result, "failed to allocate compute command buffer!");
+    }
+}
+
+// Starts recording into the slot after the ready one
+VkCommandBuffer AsyncCompute::begin() {
+    STALL_SITE("AsyncCompute::begin");
+    VkCommandBuffer cmdBuffer = m_commandBuffers[m_frameIdx];
+    m_pTimeline->wait(m_frameValues[m_frameIdx]);
+    m_slot = getNextSlot();
+    
+    vkResetCommandPool(m_pDevice->getDevice(), m_commandPools[m_frameIdx], 0);
+    VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    VkResult result = vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+    CHECK_VKRESULT(result, "failed to begin recording compute command buffer!");
+    return cmdBuffer;
+}
+
+// The GPU holds the dispatch until graphics is done reading the slot
+void AsyncCompute::submit(Timeline* pReaderTimeline) {
+    STALL_SITE("AsyncCompute::submit");
+    TRACE_SCOPE("submit compute");
+    VkCommandBuffer cmdBuffer = m_commandBuffers[m_frameIdx];
+    vkEndCommandBuffer(cmdBuffer);
+    
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &cmdBuffer;
+    
+    uint64_t value = m_pTimeline->submit(submitInfo, pReaderTimeline, m_readValues[m_slot],
+                                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    m_frameValues[m_frameIdx] = value;
+    m_writeValues[m_slot]     = value;
+    m_frameIdx = (m_frameIdx + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
+// Makes the slot written by the last submit the one graphics reads next frame
+void AsyncCompute::publish() { m_readySlot = m_slot; }
+
+void AsyncCompute::setReadValue(uint slot, uint64_t value) { m_readValues[slot] = value; }
+
+uint      AsyncCompute::getFrameIdx  () { return m_frameIdx; }
+uint      AsyncCompute::getSlot      () { return m_slot; }
+uint      AsyncCompute::getNextSlot  () { return (m_readySlot + 1) % SIMULATION_SLOT_COUNT; }
+uint      AsyncCompute::getReadySlot () { return m_readySlot; }
+uint64_t  AsyncCompute::getReadyValue() { return m_writeValues[m_readySlot]; }
+Timeline* AsyncCompute::getTimeline  () { return m_pTimeline; }
@@ -0,0 +1,56 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "device.hpp"
+#include "timeline.hpp"
+
+// Records simulation work on the compute queue one frame ahead of rendering.
+// Outputs are written into SIMULATION_SLOT_COUNT slots: while graphics reads
+// the ready slot, the next dispatch fills the other one.
+class AsyncCompute {
+    
+public:
+    ~AsyncCompute();
+    AsyncCompute();
+    
+    void cleanup();
+    
+    void setup();
+    void create();
+    
+    VkCommandBuffer begin();
+    void submit(Timeline* pReaderTimeline);
+    void publish();
+    void setReadValue(uint slot, uint64_t value);
+    
+    uint      getFrameIdx();
+    uint      getSlot();
+    uint      getNextSlot();
+    uint      getReadySlot();
+    uint64_t  getReadyValue();
+    Timeline* getTimeline();
+    
+private:
+    Cleaner m_cleaner;
+    Device* m_pDevice;
+    Timeline* m_pTimeline;
+    
+    uint32_t m_queueFamilyIndex = 0;
+    
+    // Per frame in flight
+    uint m_frameIdx = 0;
+    VECTOR<uint64_t>        m_frameValues;
+    VECTOR<VkCommandPool>   m_commandPools;
+    VECTOR<VkCommandBuffer> m_commandBuffers;
+    
+    // Per simulation slot, the compute value that wrote it and the
+    // graphics value that last read it
+    uint m_slot      = 0;
+    uint m_readySlot = 0;
+    VECTOR<uint64_t> m_writeValues;
+    VECTOR<uint64_t> m_readValues;
+    
+};
@@ -0,0 +1,53 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "barrier_batch.hpp"
+
+#include "../system.hpp"
+
+BarrierBatch::~BarrierBatch() {}
+BarrierBatch::BarrierBatch() : m_pDevice(System::Device()) {}
+
+void BarrierBatch::addImageBarrier(const VkImageMemoryBarrier2KHR& barrier) {
+    m_imageBarriers.push_back(barrier);
+}
+
+void BarrierBatch::addBufferBarrier(const VkBufferMemoryBarrier2KHR& barrier) {
+    m_bufferBarriers.push_back(barrier);
+}
+
+bool BarrierBatch::isEmpty() { return m_imageBarriers.empty() && m_bufferBarriers.empty(); }
+
+// The vectors keep their capacity, so a batch reused every frame stops allocating
+void BarrierBatch::flush(VkCommandBuffer cmdBuffer) {
+    if (isEmpty()) return;
+    
+    VkDependencyInfoKHR dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+    dependencyInfo.bufferMemoryBarrierCount = UINT32(m_bufferBarriers.size());
+    dependencyInfo.pBufferMemoryBarriers    = m_bufferBarriers.data();
+    dependencyInfo.imageMemoryBarrierCount  = UINT32(m_imageBarriers.size());
+    dependencyInfo.pImageMemoryBarriers     = m_imageBarriers.data();
+    m_pDevice->cmdPipelineBarrier2(cmdBuffer, &dependencyInfo);
+    
+    m_imageBarriers .clear();
+    m_bufferBarriers.clear();
+}
+
+VkImageMemoryBarrier2KHR BarrierBatch::GetDefaultImageBarrier() {
+    VkImageMemoryBarrier2KHR barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    return barrier;
+}
+
+VkBufferMemoryBarrier2KHR BarrierBatch::GetDefaultBufferBarrier() {
+    VkBufferMemoryBarrier2KHR barrier{};
+    barrier.sType  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+    barrier.offset = 0;
+    barrier.size   = VK_WHOLE_SIZE;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    return barrier;
+}
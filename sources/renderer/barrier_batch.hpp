@@ -0,0 +1,32 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "device.hpp"
+
+// Collects synchronization2 barriers, each with its own stage and access
+// masks, and records them with a single vkCmdPipelineBarrier2.
+class BarrierBatch {
+    
+public:
+    ~BarrierBatch();
+    BarrierBatch();
+    
+    void addImageBarrier (const VkImageMemoryBarrier2KHR&  barrier);
+    void addBufferBarrier(const VkBufferMemoryBarrier2KHR& barrier);
+    
+    bool isEmpty();
+    void flush(VkCommandBuffer cmdBuffer);
+    
+    static VkImageMemoryBarrier2KHR  GetDefaultImageBarrier();
+    static VkBufferMemoryBarrier2KHR GetDefaultBufferBarrier();
+    
+private:
+    Device* m_pDevice;
+    
+    VECTOR<VkImageMemoryBarrier2KHR>  m_imageBarriers;
+    VECTOR<VkBufferMemoryBarrier2KHR> m_bufferBarriers;
+    
+};
@@ -11,68 +11,124 @@ Commander::Commander() : m_pDevice(System::Device()) {}
 void Commander::cleanup() { m_cleaner.flush("Commander"); }
 
 void Commander::setupPool() {
+    setupPool(m_pDevice->getGraphicTimeline(), m_pDevice->getGraphicQueueIndex());
+}
+
+void Commander::setupPool(Timeline* pTimeline, uint32_t queueFamilyIndex) {
     m_poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    m_poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    m_poolInfo.queueFamilyIndex = m_pDevice->getGraphicQueueIndex();
+    m_poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    m_poolInfo.queueFamilyIndex = queueFamilyIndex;
+    m_pTimeline = pTimeline;
+    setupTransfer(m_pDevice->getTransferTimeline(), m_pDevice->getTransferQueueIndex());
+}
+
+// Uploads are recorded on their own pool so the copies can run on the
+// dedicated transfer queue while graphics keeps working.
+void Commander::setupTransfer(Timeline* pTimeline, uint32_t queueFamilyIndex) {
+    m_transferPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    m_transferPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    m_transferPoolInfo.queueFamilyIndex = queueFamilyIndex;
+    m_pTransferTimeline = pTimeline;
 }
 
 void Commander::createPool() {
-    LOG("Commander::createPool");
+    LOGV("Commander::createPool");
     VkDevice device = m_pDevice->getDevice();
     VkResult result = vkCreateCommandPool(device, &m_poolInfo, nullptr, &m_commandPool);
     CHECK_VKRESULT(result, "failed to create command pool!");
-    m_cleaner.push([=](){ vkDestroyCommandPool(device, m_commandPool, nullptr); });
+    m_cleaner.push([=](){
+        m_freeBuffers.clear();
+        m_usedBuffers.clear();
+        vkDestroyCommandPool(device, m_commandPool, nullptr);
+    });
+    
+    result = vkCreateCommandPool(device, &m_transferPoolInfo, nullptr, &m_transferPool);
+    CHECK_VKRESULT(result, "failed to create transfer command pool!");
+    m_cleaner.push([=](){
+        STALL_SITE("Commander::cleanup");
+        m_pTransferTimeline->waitLast();
+        m_pendingTransfers.clear();
+        m_freeTransfers.clear();
+        vkDestroyCommandPool(device, m_transferPool, nullptr);
+    });
 }
 
+// One-off buffers are recycled: once none is being recorded the pool is
+// reset as a whole and the executed buffers go back to the free list.
 VkCommandBuffer Commander::createCommandBuffer() {
-    LOG("Commander::createCommandBuffer");
+    LOGV("Commander::createCommandBuffer");
     VkDevice      device      = m_pDevice->getDevice();
     VkCommandPool commandPool = m_commandPool;
     
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = 1;
+    if (m_activeCount == 0 && !m_usedBuffers.empty()) {
+        vkResetCommandPool(device, commandPool, 0);
+        m_freeBuffers.insert(m_freeBuffers.end(), m_usedBuffers.begin(), m_usedBuffers.end());
+        m_usedBuffers.clear();
+    }
+    m_activeCount++;
     
     VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+    if (!m_freeBuffers.empty()) {
+        commandBuffer = m_freeBuffers.back();
+        m_freeBuffers.pop_back();
+    } else {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+        vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+    }
+    
+    if (m_pProfiler && !m_profileScope.empty())
+        m_profiledBuffers[commandBuffer] = m_pProfiler->addScope(m_profileScope);
     return commandBuffer;
 }
 
-std::vector<VkCommandBuffer> Commander::createCommandBuffers(uint32_t size) {
-    LOG("Commander::createCommandBuffers");
+VkCommandBuffer Commander::createTransferCommandBuffer() {
+    LOGV("Commander::createTransferCommandBuffer");
     VkDevice      device      = m_pDevice->getDevice();
-    VkCommandPool commandPool = m_commandPool;
+    VkCommandPool commandPool = m_transferPool;
+    recycleTransfers();
+    m_transferActiveCount++;
+    
+    if (!m_freeTransfers.empty()) {
+        VkCommandBuffer commandBuffer = m_freeTransfers.back();
+        m_freeTransfers.pop_back();
+        return commandBuffer;
+    }
     
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.level       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = size;
-    
-    std::vector<VkCommandBuffer> commandBuffers;
-    commandBuffers.resize(size);
+    allocInfo.commandBufferCount = 1;
     
-    vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data());
-    return commandBuffers;
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+    return commandBuffer;
 }
 
 void Commander::beginSingleTimeCommands(VkCommandBuffer commandBuffer) {
-    LOG("Commander::beginSingleTimeCommands");
+    LOGV("Commander::beginSingleTimeCommands");
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
     vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    
+    auto profiled = m_profiledBuffers.find(commandBuffer);
+    if (profiled == m_profiledBuffers.end()) return;
+    m_pProfiler->cmdReset(commandBuffer, profiled->second);
+    m_pProfiler->cmdBegin(commandBuffer, profiled->second);
 }
 
 void Commander::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
-    LOG("Commander::endSingleTimeCommands");
-    VkDevice      device      = m_pDevice->getDevice();
-    VkQueue       queue       = m_pDevice->getGraphicQueue();
-    VkCommandPool commandPool = m_commandPool;
+    LOGV("Commander::endSingleTimeCommands");
+    STALL_SITE("Commander::endSingleTimeCommands");
+    Timeline* pTimeline = m_pTimeline;
     
+    endProfiled(commandBuffer);
     vkEndCommandBuffer(commandBuffer);
     
     VkSubmitInfo submitInfo{};
@@ -80,8 +136,95 @@ void Commander::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers    = &commandBuffer;
     
-    vkQueueSubmit  (queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(queue);
+    uint64_t value = pTimeline->submit(submitInfo);
+    pTimeline->wait(value);
+    
+    m_usedBuffers.push_back(commandBuffer);
+    m_activeCount--;
+}
+
+// Same as above, but the GPU first waits for a transfer submit to reach
+// transferValue, so the commands can acquire what the copy released.
+void Commander::endSingleTimeCommands(VkCommandBuffer commandBuffer, uint64_t transferValue) {
+    LOGV("Commander::endSingleTimeCommands");
+    STALL_SITE("Commander::endSingleTimeCommands");
+    Timeline* pTimeline         = m_pTimeline;
+    Timeline* pTransferTimeline = m_pTransferTimeline;
+    
+    endProfiled(commandBuffer);
+    vkEndCommandBuffer(commandBuffer);
+    
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &commandBuffer;
+    
+    uint64_t value = pTimeline->submit(submitInfo, pTransferTimeline, transferValue,
+                                       VK_PIPELINE_STAGE_TRANSFER_BIT);
+    pTimeline->wait(value);
+    
+    m_usedBuffers.push_back(commandBuffer);
+    m_activeCount--;
+    recycleTransfers();
+}
+
+// Submits without blocking; the command buffer is recycled lazily once the
+// transfer timeline passes the returned value.
+uint64_t Commander::submitTransferCommands(VkCommandBuffer commandBuffer) {
+    LOGV("Commander::submitTransferCommands");
+    STALL_SITE("Commander::submitTransferCommands");
+    vkEndCommandBuffer(commandBuffer);
+    
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &commandBuffer;
+    
+    uint64_t value = m_pTransferTimeline->submit(submitInfo);
+    m_pendingTransfers.push_back({ value, commandBuffer });
+    m_transferActiveCount--;
+    return value;
+}
+
+void Commander::setProfiler(GPUProfiler* pProfiler) { m_pProfiler = pProfiler; }
+
+// Times every one-off buffer until the scope ends. One-offs complete before
+// returning, so the summed result is read back right away.
+void Commander::beginProfileScope(STRING name) {
+    if (!m_pProfiler) return;
+    m_pProfiler->beginFrame(0);
+    m_profileScope = name;
+}
+
+void Commander::endProfileScope() {
+    if (!m_pProfiler) return;
+    m_pProfiler->collect(0);
+    m_profileScope.clear();
+}
+
+Timeline* Commander::getTimeline          () { return m_pTimeline;                         }
+Timeline* Commander::getTransferTimeline  () { return m_pTransferTimeline;                 }
+uint32_t  Commander::getQueueIndex        () { return m_poolInfo.queueFamilyIndex;         }
+uint32_t  Commander::getTransferQueueIndex() { return m_transferPoolInfo.queueFamilyIndex; }
+
+// Private ==================================================
+
+void Commander::endProfiled(VkCommandBuffer commandBuffer) {
+    auto profiled = m_profiledBuffers.find(commandBuffer);
+    if (profiled == m_profiledBuffers.end()) return;
+    m_pProfiler->cmdEnd(commandBuffer, profiled->second);
+    m_profiledBuffers.erase(profiled);
+}
+
+// Buffers of a transient pool are only reset together, so the pool is reset
+// once every submitted transfer has completed and none is being recorded.
+void Commander::recycleTransfers() {
+    VkDevice device = m_pDevice->getDevice();
+    if (m_transferActiveCount > 0 || m_pendingTransfers.empty()) return;
+    if (m_pendingTransfers.back().first > m_pTransferTimeline->getCompletedValue()) return;
     
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    vkResetCommandPool(device, m_transferPool, 0);
+    for (auto& transfer : m_pendingTransfers)
+        m_freeTransfers.push_back(transfer.second);
+    m_pendingTransfers.clear();
 }
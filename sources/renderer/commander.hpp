@@ -5,6 +5,8 @@
 
 #include "../include.h"
 #include "device.hpp"
+#include "timeline.hpp"
+#include "gpu_profiler.hpp"
 
 class Commander {
     
@@ -16,13 +18,26 @@ public:
     void cleanup();
     
     void setupPool();
+    void setupPool(Timeline* pTimeline, uint32_t queueFamilyIndex);
+    void setupTransfer(Timeline* pTimeline, uint32_t queueFamilyIndex);
     void createPool();
     
-    VkCommandBuffer              createCommandBuffer();
-    std::vector<VkCommandBuffer> createCommandBuffers(uint32_t count);
+    VkCommandBuffer createCommandBuffer();
+    VkCommandBuffer createTransferCommandBuffer();
     
     void beginSingleTimeCommands(VkCommandBuffer commandBuffer);
     void endSingleTimeCommands  (VkCommandBuffer commandBuffer);
+    void endSingleTimeCommands  (VkCommandBuffer commandBuffer, uint64_t transferValue);
+    uint64_t submitTransferCommands(VkCommandBuffer commandBuffer);
+    
+    void setProfiler(GPUProfiler* pProfiler);
+    void beginProfileScope(STRING name);
+    void endProfileScope();
+    
+    Timeline* getTimeline();
+    Timeline* getTransferTimeline();
+    uint32_t  getQueueIndex();
+    uint32_t  getTransferQueueIndex();
     
     VkCommandPoolCreateInfo m_poolInfo{};
     
@@ -31,7 +46,29 @@ private:
     Cleaner m_cleaner;
     
     VkCommandPool m_commandPool = VK_NULL_HANDLE;
+    Timeline*     m_pTimeline   = nullptr;
+    
+    // Reset buffers ready to record, and executed ones waiting for the pool reset
+    uint m_activeCount = 0;
+    VECTOR<VkCommandBuffer> m_freeBuffers;
+    VECTOR<VkCommandBuffer> m_usedBuffers;
+    
+    // One-off buffers created while a profile scope is open are timed under it
+    GPUProfiler* m_pProfiler = nullptr;
+    STRING       m_profileScope;
+    std::map<VkCommandBuffer, uint> m_profiledBuffers;
+    
+    VkCommandPoolCreateInfo m_transferPoolInfo{};
+    VkCommandPool m_transferPool       = VK_NULL_HANDLE;
+    Timeline*     m_pTransferTimeline  = nullptr;
+    
+    // Transfer command buffers in flight, recycled once their value completes
+    uint m_transferActiveCount = 0;
+    VECTOR<std::pair<uint64_t, VkCommandBuffer>> m_pendingTransfers;
+    VECTOR<VkCommandBuffer> m_freeTransfers;
     
+    void recycleTransfers();
+    void endProfiled(VkCommandBuffer commandBuffer);
     
 };
 
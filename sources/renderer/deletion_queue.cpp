@@ -0,0 +1,85 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "deletion_queue.hpp"
+
+#include "../system.hpp"
+
+DeletionQueue::~DeletionQueue() {}
+DeletionQueue::DeletionQueue() : m_pDevice(System::Device()) {}
+
+void DeletionQueue::cleanup() { m_cleaner.flush("DeletionQueue"); }
+
+void DeletionQueue::create() {
+    LOG("DeletionQueue::create");
+    m_cleaner.push([=](){ releaseAll(); });
+}
+
+void DeletionQueue::retire(Timeline* pTimeline, uint64_t value, ReleaseFunc release) {
+    Entry entry{};
+    entry.values  = { { pTimeline, value } };
+    entry.release = release;
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.push_back(entry);
+}
+
+// For resources any queue may have used, released after everything
+// submitted so far has completed
+void DeletionQueue::retire(ReleaseFunc release) {
+    Device* pDevice = m_pDevice;
+    VECTOR<Timeline*> timelines = {
+        pDevice->getGraphicTimeline(),
+        pDevice->getBackgroundTimeline(),
+        pDevice->getTransferTimeline(),
+        pDevice->getComputeTimeline()
+    };
+    
+    Entry entry{};
+    for (Timeline* pTimeline : timelines)
+        entry.values.push_back({ pTimeline, pTimeline->getLastValue() });
+    entry.release = release;
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.push_back(entry);
+}
+
+void DeletionQueue::collect() {
+    VECTOR<ReleaseFunc> releases;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.begin();
+        while (it != m_entries.end()) {
+            if (!IsComplete(*it)) { ++it; continue; }
+            releases.push_back(it->release);
+            it = m_entries.erase(it);
+        }
+    }
+    for (ReleaseFunc& release : releases) release();
+}
+
+uint DeletionQueue::getPendingCount() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return UINT32(m_entries.size());
+}
+
+// Private ==================================================
+
+void DeletionQueue::releaseAll() {
+    STALL_SITE("DeletionQueue::releaseAll");
+    VECTOR<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entries.swap(m_entries);
+    }
+    for (Entry& entry : entries) {
+        for (auto& value : entry.values) value.first->wait(value.second);
+        entry.release();
+    }
+}
+
+bool DeletionQueue::IsComplete(const Entry& entry) {
+    for (auto& value : entry.values)
+        if (!value.first->isComplete(value.second)) return false;
+    return true;
+}
@@ -0,0 +1,48 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "device.hpp"
+#include "timeline.hpp"
+
+#include <mutex>
+
+// Resources retired at runtime are released once every timeline value that
+// may still use them has completed, instead of draining the GPU first.
+// collect() is called once per frame; cleanup() waits for everything left.
+class DeletionQueue {
+    
+    typedef std::function<void()> ReleaseFunc;
+    
+    struct Entry {
+        VECTOR<std::pair<Timeline*, uint64_t>> values;
+        ReleaseFunc release;
+    };
+    
+public:
+    ~DeletionQueue();
+    DeletionQueue();
+    
+    void cleanup();
+    void create();
+    
+    void retire(Timeline* pTimeline, uint64_t value, ReleaseFunc release);
+    void retire(ReleaseFunc release);
+    void collect();
+    
+    uint getPendingCount();
+    
+private:
+    Cleaner m_cleaner;
+    Device* m_pDevice;
+    
+    std::mutex    m_mutex;
+    VECTOR<Entry> m_entries;
+    
+    void releaseAll();
+    
+    static bool IsComplete(const Entry& entry);
+    
+};
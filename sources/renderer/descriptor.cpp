@@ -41,7 +41,7 @@ void Descriptor::addLayoutBindings(uint set, uint binding, VkDescriptorType type
 }
 
 void Descriptor::createLayout(uint set) {
-    LOG("Descriptor::createLayout");
+    LOGV("Descriptor::createLayout");
     VkDevice device = m_pDevice->getDevice();
     DescriptorSetData data = m_dataMap[set];
     
@@ -58,7 +58,7 @@ void Descriptor::createLayout(uint set) {
 }
 
 void Descriptor::createPool() {
-    LOG("Descriptor::createPool");
+    LOGV("Descriptor::createPool");
     VkDevice device = m_pDevice->getDevice();
     DescriptorSetDataMap descDataMap = m_dataMap;
     VECTOR<VkDescriptorPoolSize> poolSizes = getPoolSizes();
@@ -109,9 +109,10 @@ void Descriptor::setupPointerImage(uint set, uint setIdx, uint binding, VkDescri
 }
 
 void Descriptor::update(uint set) {
-    LOG("Descriptor::update");
+    LOGV("Descriptor::update");
     VkDevice device = m_pDevice->getDevice();
-    VECTOR<VkWriteDescriptorSet> writeSets = m_dataMap[set].writeSets;
+    VECTOR<VkWriteDescriptorSet>& writeSets = m_dataMap[set].writeSets;
+    STALL_SCOPE(UpdateDescriptors);
     vkUpdateDescriptorSets(device, UINT32(writeSets.size()), writeSets.data(), 0, nullptr);
 }
 
@@ -123,7 +124,11 @@ VkDescriptorSet Descriptor::getDescriptorSet(uint set) {
     return m_dataMap[set].descriptorSets[0];
 }
 
-VECTOR<VkDescriptorSet> Descriptor::getDescriptorSets(uint set) {
+VkDescriptorSet Descriptor::getDescriptorSet(uint set, uint setIdx) {
+    return m_dataMap[set].descriptorSets[setIdx];
+}
+
+const VECTOR<VkDescriptorSet>& Descriptor::getDescriptorSets(uint set) {
     return m_dataMap[set].descriptorSets;
 }
 
@@ -132,7 +137,7 @@ VECTOR<VkDescriptorSet> Descriptor::getDescriptorSets(uint set) {
 
 
 void Descriptor::allocateDescriptorSet(DescriptorSetData* data) {
-    LOG("Descriptor::allocateData");
+    LOGV("Descriptor::allocateData");
     VkDevice device = m_pDevice->getDevice();
     VkDescriptorPool pool = m_pool;
     
@@ -168,7 +173,7 @@ VECTOR<VkDescriptorPoolSize> Descriptor::getPoolSizes() {
 }
 
 int Descriptor::findWriteSetIdx(uint set, uint binding) {
-    VECTOR<VkWriteDescriptorSet> writeSets = m_dataMap[set].writeSets;
+    VECTOR<VkWriteDescriptorSet>& writeSets = m_dataMap[set].writeSets;
     for (uint i = 0; i < writeSets.size(); i++)
         if (writeSets[i].dstBinding == binding) return i;
     return -1;
@@ -35,7 +35,8 @@ public:
     
     VkDescriptorSetLayout   getDescriptorLayout(uint layoutId);
     VkDescriptorSet         getDescriptorSet(uint layoutId);
-    VECTOR<VkDescriptorSet> getDescriptorSets(uint layoutId);
+    VkDescriptorSet         getDescriptorSet(uint layoutId, uint setIdx);
+    const VECTOR<VkDescriptorSet>& getDescriptorSets(uint layoutId);
     
 private:
     
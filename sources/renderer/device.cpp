@@ -2,13 +2,18 @@
 //
 
 #include "device.hpp"
+#include "timeline.hpp"
+#include "stall_auditor.hpp"
+
+#include <fstream>
 
 Device::Device() { }
 Device::~Device() { }
 
 void Device::cleanup() { m_cleaner.flush("Device"); }
 
-void Device::setup() {
+// Headless devices need neither GLFW's instance extensions nor a swapchain
+void Device::setup(bool headless) {
     LOG("Device::setup");
     USE_FUNC(DebugCallback);
     
@@ -35,14 +40,24 @@ void Device::setup() {
     deviceFeatures.multiViewport     = VK_TRUE;
     deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
     
-    VECTOR<const char*> instanceExtensions = GetGLFWInstanceExtensions();
+    VECTOR<const char*> instanceExtensions;
+    if (!headless) instanceExtensions = GetGLFWInstanceExtensions();
     instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
-    VECTOR<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME, VK_EXT_SHADER_VIEWPORT_INDEX_LAYER_EXTENSION_NAME };
+    VECTOR<const char*> deviceExtensions = { VK_EXT_SHADER_VIEWPORT_INDEX_LAYER_EXTENSION_NAME, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME };
+    if (!headless) deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
     VECTOR<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
     bool result = CheckLayerSupport(validationLayers);
+    
+    // Headless runs target machines without the SDK, e.g. CI on lavapipe
+    if (headless && !result) {
+        LOG("VK_LAYER_KHRONOS_validation unavailable, running without validation");
+        validationLayers.clear();
+        result = true;
+    }
     CHECK_BOOL(result, "validation layers requested, but not available!");
     
+    m_headless            = headless;
     m_appInfo             = appInfo;
     m_debugInfo           = debugInfo;
     m_deviceFeatures      = deviceFeatures;
@@ -93,11 +108,14 @@ void Device::selectPhysicalDevice() {
     LOG("Device::selectPhysicalDevice");
     VkInstance   instance = m_instance;
     VkSurfaceKHR surface  = m_surface;
+    bool         headless = m_headless;
     VkPhysicalDeviceFeatures deviceFeatures   = m_deviceFeatures;
     VECTOR<const char*>      deviceExtensions = m_vDeviceExtensions;
     
     int graphicQueueIndex = 0;
     int presentQueueIndex = 0;
+    int transferQueueIndex = 0;
+    int computeQueueIndex = 0;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     
     VECTOR<VkSurfaceFormatKHR> formats;
@@ -110,13 +128,17 @@ void Device::selectPhysicalDevice() {
         LOG(m_deviceProperties.deviceName);
 
         physicalDevice    = tempDevice;
-        presentQueueIndex = FindPresentQueueIndex(tempDevice, surface);
         graphicQueueIndex = FindGraphicQueueIndex(tempDevice);
+        presentQueueIndex = headless ? graphicQueueIndex : FindPresentQueueIndex(tempDevice, surface);
+        transferQueueIndex = FindTransferQueueIndex(tempDevice);
+        computeQueueIndex = FindComputeQueueIndex(tempDevice);
         
-        formats = GetSurfaceFormatKHR(tempDevice, surface);
-        modes   = GetPresentModeKHR  (tempDevice, surface);
+        if (!headless) {
+            formats = GetSurfaceFormatKHR(tempDevice, surface);
+            modes   = GetPresentModeKHR  (tempDevice, surface);
+        }
         
-        bool swapchainAdequate  = !formats.empty() && !modes.empty();
+        bool swapchainAdequate  = headless || (!formats.empty() && !modes.empty());
         bool hasFamilyIndex     = graphicQueueIndex > -1 && presentQueueIndex > -1;
         bool featureSupported   = CheckFeatureSupport(tempDevice, deviceFeatures);
         bool extensionSupported = CheckDeviceExtensionSupport(tempDevice, deviceExtensions);
@@ -124,11 +146,16 @@ void Device::selectPhysicalDevice() {
         if (swapchainAdequate && hasFamilyIndex && extensionSupported && featureSupported) break;
     }
     
-    m_surfaceFormat     = FindSufraceFormat(formats);
-    m_presentMode       = FindPresentMode(modes);
+    // Headless frames are plain color images, see Image::setupForColor
+    m_surfaceFormat     = headless ? VkSurfaceFormatKHR{ VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR }
+                                   : FindSufraceFormat(formats);
+    m_presentMode       = headless ? VK_PRESENT_MODE_FIFO_KHR : FindPresentMode(modes);
     m_physicalDevice    = physicalDevice;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
     m_graphicQueueIndex = graphicQueueIndex;
     m_presentQueueIndex = presentQueueIndex;
+    m_transferQueueIndex = transferQueueIndex > -1 ? transferQueueIndex : graphicQueueIndex;
+    m_computeQueueIndex = computeQueueIndex > -1 ? computeQueueIndex : graphicQueueIndex;
 }
 
 void Device::createLogicalDevice() {
@@ -137,21 +164,46 @@ void Device::createLogicalDevice() {
     VkPhysicalDeviceFeatures deviceFeatures = m_deviceFeatures;
     VECTOR<const char*> deviceExtensions  = m_vDeviceExtensions;
     VECTOR<const char*> validationLayers  = m_vValidationLayers;
-    std::set<uint32_t> queueFamilyIndices = {m_graphicQueueIndex, m_presentQueueIndex};
+    std::set<uint32_t> queueFamilyIndices = {
+        m_graphicQueueIndex, m_presentQueueIndex, m_transferQueueIndex, m_computeQueueIndex
+    };
     
-    float queuePriority = 1.f;
+    // Optional, budgets fall back to the heap sizes without it
+    bool hasMemoryBudget = CheckDeviceExtensionSupport(physicalDevice, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME });
+    if (hasMemoryBudget) deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    LOG("VK_EXT_memory_budget " << (hasMemoryBudget ? "enabled" : "unavailable"));
+    
+    // Must be enabled where exposed (MoltenVK), other drivers don't have it
+    bool isPortability = CheckDeviceExtensionSupport(physicalDevice, { VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME });
+    if (isPortability) deviceExtensions.push_back(VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME);
+    
+    // Second graphic queue for background bakes, shared with rendering if the family has one queue
+    uint32_t graphicQueueCount = GetQueueFamilyProperties(physicalDevice)[m_graphicQueueIndex].queueCount;
+    uint32_t backgroundQueueIdx = graphicQueueCount > 1 ? 1 : 0;
+    
+    float queuePriorities[] = { 1.f, .5f };
     VECTOR<VkDeviceQueueCreateInfo> queueInfos;
     for (uint32_t familyIndex : queueFamilyIndices) {
         VkDeviceQueueCreateInfo queueInfo{};
         queueInfo.sType             = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueInfo.queueFamilyIndex  = familyIndex;
-        queueInfo.queueCount        = 1;
-        queueInfo.pQueuePriorities  = &queuePriority;
+        queueInfo.queueCount        = familyIndex == m_graphicQueueIndex ? backgroundQueueIdx + 1 : 1;
+        queueInfo.pQueuePriorities  = queuePriorities;
         queueInfos.push_back(queueInfo);
     }
     
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+    synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    synchronization2Features.synchronization2 = VK_TRUE;
+    
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    timelineFeatures.pNext = &synchronization2Features;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+    
     VkDeviceCreateInfo deviceInfo{};
     deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.pNext = &timelineFeatures;
     deviceInfo.queueCreateInfoCount     = UINT32(queueInfos.size());
     deviceInfo.pQueueCreateInfos        = queueInfos.data();
     deviceInfo.pEnabledFeatures         = &deviceFeatures;
@@ -165,15 +217,83 @@ void Device::createLogicalDevice() {
     CHECK_VKRESULT(result, "failed to create logical device");
     
     m_device = device;
+    m_hasMemoryBudget = hasMemoryBudget;
+    updateMemoryBudget();
     vkGetDeviceQueue(device, m_graphicQueueIndex, 0, &m_graphicQueue);
     vkGetDeviceQueue(device, m_presentQueueIndex, 0, &m_presentQueue);
+    vkGetDeviceQueue(device, m_graphicQueueIndex, backgroundQueueIdx, &m_backgroundQueue);
+    vkGetDeviceQueue(device, m_transferQueueIndex, 0, &m_transferQueue);
+    vkGetDeviceQueue(device, m_computeQueueIndex, 0, &m_computeQueue);
+    
+    m_pfnCmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2KHR) vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR");
+    CHECK_NULLPTR(m_pfnCmdPipelineBarrier2, "failed to load vkCmdPipelineBarrier2KHR!");
     m_cleaner.push([=](){ vkDestroyDevice(m_device, nullptr); });
 }
 
-uint32_t Device::findMemoryTypeIndex(uint32_t typeFilter, VkMemoryPropertyFlags flags) {
+void Device::selectHDRFormats() {
+    LOG("Device::selectHDRFormats");
+    // Storage images are declared rgba16f in the compute shaders
+    m_hdrStorageFormat = findSupportedFormat({ VK_FORMAT_R16G16B16A16_SFLOAT },
+                                             VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT |
+                                             VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+                                             VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                                             VK_FORMAT_FEATURE_BLIT_DST_BIT);
+    m_hdrAttachmentFormat = findSupportedFormat({ VK_FORMAT_R16G16B16A16_SFLOAT,
+                                                  VK_FORMAT_R32G32B32A32_SFLOAT },
+                                                VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT |
+                                                VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+                                                VK_FORMAT_FEATURE_BLIT_SRC_BIT);
+    m_hdrSampledFormat = findSupportedFormat({ VK_FORMAT_E5B9G9R9_UFLOAT_PACK32,
+                                               VK_FORMAT_B10G11R11_UFLOAT_PACK32,
+                                               VK_FORMAT_R16G16B16A16_SFLOAT },
+                                             VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+                                             VK_FORMAT_FEATURE_BLIT_DST_BIT);
+    LOG("HDR storage format " << m_hdrStorageFormat <<
+        " attachment format " << m_hdrAttachmentFormat <<
+        " sampled format " << m_hdrSampledFormat);
+}
+
+// Queues shared with the graphic queue share its timeline
+void Device::createTimelines() {
+    LOG("Device::createTimelines");
+    m_pGraphicTimeline = new Timeline(this, m_graphicQueue);
+    m_pGraphicTimeline->create();
+    m_cleaner.push([=](){ m_pGraphicTimeline->cleanup(); });
+    
+    m_pBackgroundTimeline = m_pGraphicTimeline;
+    if (m_backgroundQueue != m_graphicQueue) {
+        m_pBackgroundTimeline = new Timeline(this, m_backgroundQueue);
+        m_pBackgroundTimeline->create();
+        m_cleaner.push([=](){ m_pBackgroundTimeline->cleanup(); });
+    }
+    
+    m_pTransferTimeline = m_pGraphicTimeline;
+    if (m_transferQueue != m_graphicQueue) {
+        m_pTransferTimeline = new Timeline(this, m_transferQueue);
+        m_pTransferTimeline->create();
+        m_cleaner.push([=](){ m_pTransferTimeline->cleanup(); });
+    }
+    
+    m_pComputeTimeline = m_pGraphicTimeline;
+    if (m_computeQueue != m_graphicQueue) {
+        m_pComputeTimeline = new Timeline(this, m_computeQueue);
+        m_pComputeTimeline->create();
+        m_cleaner.push([=](){ m_pComputeTimeline->cleanup(); });
+    }
+}
+
+VkFormat Device::findSupportedFormat(VECTOR<VkFormat> candidates, VkFormatFeatureFlags features) {
     VkPhysicalDevice physicalDevice = m_physicalDevice;
-    VkPhysicalDeviceMemoryProperties properties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &properties);
+    for (VkFormat format : candidates) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+        if ((properties.optimalTilingFeatures & features) == features) return format;
+    }
+    throw std::runtime_error("failed to find supported format!");
+}
+
+uint32_t Device::findMemoryTypeIndex(uint32_t typeFilter, VkMemoryPropertyFlags flags) {
+    VkPhysicalDeviceMemoryProperties& properties = m_memoryProperties;
     
     for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
         if (typeFilter & (1 << i) &&
@@ -191,9 +311,141 @@ VkSurfaceCapabilitiesKHR Device::getSurfaceCapabilities() {
     return capabilities;
 }
 
-void Device::waitIdle() { vkDeviceWaitIdle(m_device); }
-void Device::waitAllQueueIdle() { vkQueueWaitIdle(m_presentQueue); }
+void Device::waitIdle() {
+    STALL_SITE("Device::waitIdle");
+    STALL_SCOPE(DeviceWaitIdle);
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    vkDeviceWaitIdle(m_device);
+}
+
+// Rendering and uploads are waited on through their timelines. Presentation
+// has no timeline, so the present queue is still drained for swapchain teardown.
+// Headless, the present queue is the graphic queue.
+void Device::waitAllQueueIdle() {
+    STALL_SITE("Device::waitAllQueueIdle");
+    m_pGraphicTimeline->waitLast();
+    m_pBackgroundTimeline->waitLast();
+    m_pTransferTimeline->waitLast();
+    m_pComputeTimeline->waitLast();
+    STALL_SCOPE(QueueWaitIdle);
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    vkQueueWaitIdle(m_presentQueue);
+}
+
+// Every barrier in the renderer goes through here so they can be counted
+void Device::cmdPipelineBarrier2(VkCommandBuffer cmdBuffer, const VkDependencyInfoKHR* pDependencyInfo) {
+    m_barrierCount += pDependencyInfo->memoryBarrierCount +
+                      pDependencyInfo->bufferMemoryBarrierCount +
+                      pDependencyInfo->imageMemoryBarrierCount;
+    m_barrierCallCount++;
+    m_pfnCmdPipelineBarrier2(cmdBuffer, pDependencyInfo);
+}
+
+// Called once per frame, the getters report the frame that just ended
+void Device::resetBarrierCount() {
+    m_lastBarrierCount     = m_barrierCount.exchange(0);
+    m_lastBarrierCallCount = m_barrierCallCount.exchange(0);
+}
+
+uint32_t Device::getBarrierCount()     { return m_lastBarrierCount; }
+uint32_t Device::getBarrierCallCount() { return m_lastBarrierCallCount; }
+
+// Every vkAllocateMemory and vkFreeMemory reports here, from any thread
+void Device::addMemory(VkDeviceSize size, uint32_t memoryTypeIndex, MemoryTag tag) {
+    VkDeviceSize allocated = m_allocatedMemory += size;
+    VkDeviceSize peak      = m_peakMemory;
+    while (allocated > peak && !m_peakMemory.compare_exchange_weak(peak, allocated));
+    m_allocationCount++;
+    m_taggedMemory[tag] += size;
+    m_heapMemory[m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] += size;
+}
+
+void Device::removeMemory(VkDeviceSize size, uint32_t memoryTypeIndex, MemoryTag tag) {
+    m_allocatedMemory -= size;
+    m_allocationCount--;
+    m_taggedMemory[tag] -= size;
+    m_heapMemory[m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex] -= size;
+}
+
+// Called once per frame. The driver's usage includes other processes and
+// allocations the app does not track, e.g. the swapchain.
+void Device::updateMemoryBudget() {
+    VkPhysicalDeviceMemoryProperties& properties = m_memoryProperties;
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    if (m_hasMemoryBudget) {
+        VkPhysicalDeviceMemoryProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties2.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(m_physicalDevice, &properties2);
+    }
+    
+    m_heapBudgets.resize(properties.memoryHeapCount);
+    for (uint32_t i = 0; i < properties.memoryHeapCount; i++) {
+        HeapBudget& heap = m_heapBudgets[i];
+        heap.allocated   = m_heapMemory[i];
+        heap.deviceLocal = properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+        heap.budget      = m_hasMemoryBudget ? budget.heapBudget[i] : properties.memoryHeaps[i].size;
+        heap.usage       = m_hasMemoryBudget ? budget.heapUsage[i]  : heap.allocated;
+    }
+}
+
+// Sizes in bytes, per tag and per heap as of the last budget update
+bool Device::exportMemoryJSON(STRING path) {
+    LOG("Device::exportMemoryJSON " + path);
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        ERR("failed to open memory file " + path);
+        return false;
+    }
+    
+    file << "{\n";
+    file << "  \"device\": \"" << getDeviceName() << "\",\n";
+    file << "  \"memory_budget\": " << (m_hasMemoryBudget ? "true" : "false") << ",\n";
+    file << "  \"allocated\": " << getAllocatedMemory() << ",\n";
+    file << "  \"peak\": " << getPeakMemory() << ",\n";
+    file << "  \"allocations\": " << getAllocationCount() << ",\n";
+    file << "  \"tags\": {\n";
+    for (uint i = 0; i < MEMORY_TAG_COUNT; i++) {
+        file << "    \"" << MemoryTagName(MemoryTag(i)) << "\": " << m_taggedMemory[i]
+             << (i + 1 < MEMORY_TAG_COUNT ? ",\n" : "\n");
+    }
+    file << "  },\n";
+    file << "  \"heaps\": [\n";
+    for (uint i = 0; i < m_heapBudgets.size(); i++) {
+        HeapBudget& heap = m_heapBudgets[i];
+        file << "    { \"index\": " << i
+             << ", \"device_local\": " << (heap.deviceLocal ? "true" : "false")
+             << ", \"budget\": " << heap.budget
+             << ", \"usage\": " << heap.usage
+             << ", \"allocated\": " << heap.allocated << " }"
+             << (i + 1 < m_heapBudgets.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n";
+    file << "}\n";
+    return true;
+}
+
+VkDeviceSize Device::getAllocatedMemory() { return m_allocatedMemory; }
+VkDeviceSize Device::getPeakMemory()      { return m_peakMemory; }
+uint32_t     Device::getAllocationCount() { return m_allocationCount; }
+VkDeviceSize Device::getTaggedMemory(MemoryTag tag) { return m_taggedMemory[tag]; }
+bool         Device::hasMemoryBudget()    { return m_hasMemoryBudget; }
+const VECTOR<Device::HeapBudget>& Device::getHeapBudgets() { return m_heapBudgets; }
+
+const char* Device::MemoryTagName(MemoryTag tag) {
+    switch (tag) {
+        case MEMORY_TAG_TEXTURE: return "texture";
+        case MEMORY_TAG_IBL    : return "ibl";
+        case MEMORY_TAG_SIM    : return "sim";
+        case MEMORY_TAG_STAGING: return "staging";
+        case MEMORY_TAG_FRAME  : return "frame";
+        case MEMORY_TAG_MESH   : return "mesh";
+        default                : return "other";
+    }
+}
 
+bool               Device::isHeadless()        { return m_headless; }
 VkInstance         Device::getInstance()       { return m_instance; }
 VkSurfaceKHR       Device::getSurface()        { return m_surface; }
 VkPhysicalDevice   Device::getPhysicalDevice() { return m_physicalDevice; }
@@ -201,11 +453,34 @@ VkDevice           Device::getDevice()         { return m_device; }
 
 VkQueue            Device::getGraphicQueue()   { return m_graphicQueue; }
 VkQueue            Device::getPresentQueue()   { return m_presentQueue; }
+VkQueue            Device::getBackgroundQueue(){ return m_backgroundQueue; }
+VkQueue            Device::getTransferQueue()  { return m_transferQueue; }
+VkQueue            Device::getComputeQueue()   { return m_computeQueue; }
+std::mutex&        Device::getQueueMutex()     { return m_queueMutex; }
+Timeline*          Device::getGraphicTimeline()    { return m_pGraphicTimeline; }
+Timeline*          Device::getBackgroundTimeline() { return m_pBackgroundTimeline; }
+Timeline*          Device::getTransferTimeline()   { return m_pTransferTimeline; }
+Timeline*          Device::getComputeTimeline()    { return m_pComputeTimeline; }
 VkSurfaceFormatKHR Device::getSurfaceFormat()  { return m_surfaceFormat; }
 VkPresentModeKHR   Device::getPresentMode()    { return m_presentMode;}
 
 uint32_t Device::getGraphicQueueIndex() { return m_graphicQueueIndex; }
 uint32_t Device::getPresentQueueIndex() { return m_presentQueueIndex; }
+uint32_t Device::getTransferQueueIndex() { return m_transferQueueIndex; }
+bool     Device::hasTransferQueue()      { return m_transferQueueIndex != m_graphicQueueIndex; }
+uint32_t Device::getComputeQueueIndex()  { return m_computeQueueIndex; }
+bool     Device::hasComputeQueue()       { return m_computeQueueIndex != m_graphicQueueIndex; }
+float    Device::getTimestampPeriod()    { return m_deviceProperties.limits.timestampPeriod; }
+STRING   Device::getDeviceName()         { return m_deviceProperties.deviceName; }
+
+bool Device::hasTimestamps(uint32_t queueFamilyIndex) {
+    VECTOR<VkQueueFamilyProperties> queueFamilies = GetQueueFamilyProperties(m_physicalDevice);
+    return queueFamilies[queueFamilyIndex].timestampValidBits > 0;
+}
+
+VkFormat Device::getHDRStorageFormat()    { return m_hdrStorageFormat; }
+VkFormat Device::getHDRAttachmentFormat() { return m_hdrAttachmentFormat; }
+VkFormat Device::getHDRSampledFormat()    { return m_hdrSampledFormat; }
 
 
 // Private ==================================================
@@ -286,6 +561,27 @@ int Device::FindPresentQueueIndex(VkPhysicalDevice physicalDevice, VkSurfaceKHR
     return -1;
 }
 
+// Transfer only family, usually backed by the DMA engines
+int Device::FindTransferQueueIndex(VkPhysicalDevice physicalDevice) {
+    VECTOR<VkQueueFamilyProperties> queueFamilies = GetQueueFamilyProperties(physicalDevice);
+    for (int i = 0; i < queueFamilies.size(); i++) {
+        VkQueueFlags flags = queueFamilies[i].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) &&
+            !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) return i;
+    }
+    return -1;
+}
+
+// Compute family without graphics, the one that runs alongside rendering
+int Device::FindComputeQueueIndex(VkPhysicalDevice physicalDevice) {
+    VECTOR<VkQueueFamilyProperties> queueFamilies = GetQueueFamilyProperties(physicalDevice);
+    for (int i = 0; i < queueFamilies.size(); i++) {
+        VkQueueFlags flags = queueFamilies[i].queueFlags;
+        if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) return i;
+    }
+    return -1;
+}
+
 bool Device::CheckLayerSupport(VECTOR<const char*> layers) {
     uint32_t count;
     vkEnumerateInstanceLayerProperties(&count, nullptr);
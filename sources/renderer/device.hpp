@@ -5,23 +5,69 @@
 
 #include "../include.h"
 
+#include <mutex>
+#include <atomic>
+
+class Timeline;
+
+// What device memory is allocated for, so usage can be broken down per tag
+enum MemoryTag {
+    MEMORY_TAG_OTHER,
+    MEMORY_TAG_TEXTURE,
+    MEMORY_TAG_IBL,
+    MEMORY_TAG_SIM,
+    MEMORY_TAG_STAGING,
+    MEMORY_TAG_FRAME,
+    MEMORY_TAG_MESH,
+    MEMORY_TAG_COUNT
+};
+
 class Device {
     
 public:
+    // Budget and usage are the driver's when VK_EXT_memory_budget is
+    // available, otherwise the heap size and what the app allocated itself
+    struct HeapBudget {
+        VkDeviceSize budget    = 0;
+        VkDeviceSize usage     = 0;
+        VkDeviceSize allocated = 0;
+        bool         deviceLocal = false;
+    };
+    
     Device();
     ~Device();
     
     void cleanup();
     
-    void setup();
+    void setup(bool headless = false);
     void createInstance();
     void createSurface(GLFWwindow* m_window);
     void createDebugMessenger();
     void selectPhysicalDevice();
     void createLogicalDevice();
+    void selectHDRFormats();
+    void createTimelines();
     void waitIdle();
     void waitAllQueueIdle();
     
+    void cmdPipelineBarrier2(VkCommandBuffer cmdBuffer, const VkDependencyInfoKHR* pDependencyInfo);
+    void resetBarrierCount();
+    uint32_t getBarrierCount();
+    uint32_t getBarrierCallCount();
+    
+    void addMemory   (VkDeviceSize size, uint32_t memoryTypeIndex, MemoryTag tag);
+    void removeMemory(VkDeviceSize size, uint32_t memoryTypeIndex, MemoryTag tag);
+    void updateMemoryBudget();
+    bool exportMemoryJSON(STRING path);
+    VkDeviceSize getAllocatedMemory();
+    VkDeviceSize getPeakMemory();
+    uint32_t     getAllocationCount();
+    VkDeviceSize getTaggedMemory(MemoryTag tag);
+    bool         hasMemoryBudget();
+    const VECTOR<HeapBudget>& getHeapBudgets();
+    static const char* MemoryTagName(MemoryTag tag);
+    
+    bool               isHeadless();
     VkInstance         getInstance();
     VkSurfaceKHR       getSurface();
     VkPhysicalDevice   getPhysicalDevice();
@@ -29,12 +75,32 @@ public:
     
     VkQueue            getGraphicQueue();
     VkQueue            getPresentQueue();
+    VkQueue            getBackgroundQueue();
+    VkQueue            getTransferQueue();
+    VkQueue            getComputeQueue();
+    std::mutex&        getQueueMutex();
+    Timeline*          getGraphicTimeline();
+    Timeline*          getBackgroundTimeline();
+    Timeline*          getTransferTimeline();
+    Timeline*          getComputeTimeline();
     VkSurfaceFormatKHR getSurfaceFormat();
     VkPresentModeKHR   getPresentMode();
     
     uint32_t getGraphicQueueIndex();
     uint32_t getPresentQueueIndex();
+    uint32_t getTransferQueueIndex();
+    bool     hasTransferQueue();
+    uint32_t getComputeQueueIndex();
+    bool     hasComputeQueue();
+    bool     hasTimestamps(uint32_t queueFamilyIndex);
+    float    getTimestampPeriod();
+    STRING   getDeviceName();
     uint32_t findMemoryTypeIndex(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    VkFormat findSupportedFormat(VECTOR<VkFormat> candidates, VkFormatFeatureFlags features);
+    
+    VkFormat getHDRStorageFormat();
+    VkFormat getHDRAttachmentFormat();
+    VkFormat getHDRSampledFormat();
     
     VkSurfaceCapabilitiesKHR getSurfaceCapabilities();
     
@@ -49,22 +115,55 @@ private:
     VECTOR<const char*> m_vDeviceExtensions{};
     VECTOR<const char*> m_vValidationLayers{};
     
+    bool             m_headless = false;
     VkInstance       m_instance;
-    VkSurfaceKHR     m_surface;
+    VkSurfaceKHR     m_surface  = VK_NULL_HANDLE;
     VkPhysicalDevice m_physicalDevice;
     VkDevice         m_device;
     
-    VkPhysicalDeviceProperties m_deviceProperties{};
-    VkDebugUtilsMessengerEXT   m_debugMessenger;
+    VkPhysicalDeviceProperties       m_deviceProperties{};
+    VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+    VkDebugUtilsMessengerEXT         m_debugMessenger;
 
     VkSurfaceFormatKHR m_surfaceFormat{};
     VkPresentModeKHR   m_presentMode  {};
     
     uint32_t m_graphicQueueIndex = 0;
     uint32_t m_presentQueueIndex = 0;
+    uint32_t m_transferQueueIndex = 0;
+    uint32_t m_computeQueueIndex = 0;
 
     VkQueue m_graphicQueue;
     VkQueue m_presentQueue;
+    VkQueue m_backgroundQueue;
+    VkQueue m_transferQueue;
+    VkQueue m_computeQueue;
+    
+    std::mutex m_queueMutex;
+    
+    Timeline* m_pGraphicTimeline;
+    Timeline* m_pBackgroundTimeline;
+    Timeline* m_pTransferTimeline;
+    Timeline* m_pComputeTimeline;
+    
+    PFN_vkCmdPipelineBarrier2KHR m_pfnCmdPipelineBarrier2 = nullptr;
+    // Current frame counts, and the totals of the last finished frame
+    std::atomic<uint32_t> m_barrierCount{0};
+    std::atomic<uint32_t> m_barrierCallCount{0};
+    uint32_t m_lastBarrierCount     = 0;
+    uint32_t m_lastBarrierCallCount = 0;
+    // Device memory currently allocated through vkAllocateMemory
+    std::atomic<VkDeviceSize> m_allocatedMemory{0};
+    std::atomic<VkDeviceSize> m_peakMemory{0};
+    std::atomic<uint32_t>     m_allocationCount{0};
+    std::atomic<VkDeviceSize> m_taggedMemory[MEMORY_TAG_COUNT] = {};
+    std::atomic<VkDeviceSize> m_heapMemory[VK_MAX_MEMORY_HEAPS] = {};
+    bool                      m_hasMemoryBudget = false;
+    VECTOR<HeapBudget>        m_heapBudgets;
+    
+    VkFormat m_hdrStorageFormat    = VK_FORMAT_R32G32B32A32_SFLOAT;
+    VkFormat m_hdrAttachmentFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+    VkFormat m_hdrSampledFormat    = VK_FORMAT_R32G32B32A32_SFLOAT;
 
     static VkSurfaceFormatKHR FindSufraceFormat(VECTOR<VkSurfaceFormatKHR> surfaceFormats);
     static VkPresentModeKHR   FindPresentMode  (VECTOR<VkPresentModeKHR>   presentModes);
@@ -77,6 +176,8 @@ private:
     
     static int FindGraphicQueueIndex(VkPhysicalDevice physicalDevice);
     static int FindPresentQueueIndex(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
+    static int FindTransferQueueIndex(VkPhysicalDevice physicalDevice);
+    static int FindComputeQueueIndex(VkPhysicalDevice physicalDevice);
 
     
     static bool CheckLayerSupport(VECTOR<const char*> layers);
@@ -0,0 +1,182 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "gpu_profiler.hpp"
+
+#include "../system.hpp"
+
+#include <algorithm>
+
+GPUProfiler::~GPUProfiler() {}
+GPUProfiler::GPUProfiler() : m_pDevice(System::Device()) {}
+
+void GPUProfiler::cleanup() { m_cleaner.flush("GPUProfiler"); }
+
+// Queue families without timestamp support leave the profiler disabled, every
+// call then does nothing
+void GPUProfiler::setup(STRING name, uint32_t queueFamilyIndex, uint slotCount, uint maxScopes) {
+    m_name      = name;
+    m_enabled   = m_pDevice->hasTimestamps(queueFamilyIndex);
+    m_period    = m_pDevice->getTimestampPeriod();
+    m_maxScopes = maxScopes;
+    m_slots.resize(slotCount);
+    for (Slot& slot : m_slots) {
+        slot.scopes   .reserve(maxScopes);
+        slot.results  .resize(maxScopes * 4);
+        slot.durations.resize(maxScopes);
+    }
+    m_sorted.reserve(PROFILER_HISTORY);
+}
+
+void GPUProfiler::create() {
+    LOG("GPUProfiler::create");
+    VkDevice device = m_pDevice->getDevice();
+    if (!m_enabled) return;
+    
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = m_maxScopes * 2;
+    
+    for (Slot& slot : m_slots) {
+        VkResult result = vkCreateQueryPool(device, &queryPoolInfo, nullptr, &slot.queryPool);
+        CHECK_VKRESULT(result, "failed to create timestamp query pool!");
+    }
+    m_cleaner.push([=](){
+        for (Slot& slot : m_slots) vkDestroyQueryPool(device, slot.queryPool, nullptr);
+    });
+}
+
+// The slot's previous submission must have completed
+void GPUProfiler::beginFrame(uint slot) {
+    collect(slot);
+    m_slot = slot;
+}
+
+void GPUProfiler::collect(uint slot) {
+    VkDevice device = m_pDevice->getDevice();
+    Slot&    data   = m_slots[slot];
+    uint32_t count  = UINT32(data.scopes.size());
+    if (!m_enabled || count == 0) return;
+    
+    // Value and availability for every query
+    VECTOR<uint64_t>& results = data.results;
+    vkGetQueryPoolResults(device, data.queryPool, 0, count * 2,
+                          count * 4 * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+                          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    
+    // Scopes sharing a name add up into the first of them, -1 when unavailable
+    VECTOR<float>& durations = data.durations;
+    for (uint i = 0; i < count; i++) {
+        uint64_t begin = results[i * 4 + 0];
+        uint64_t end   = results[i * 4 + 2];
+        bool available = results[i * 4 + 1] && results[i * 4 + 3];
+        durations[i] = available && end >= begin ? (end - begin) * m_period / 1000000.f : -1.f;
+        
+        uint first = 0;
+        while (data.scopes[first] != data.scopes[i]) first++;
+        if (first == i || durations[i] < 0.f) continue;
+        durations[first] = std::max(durations[first], 0.f) + durations[i];
+        durations[i]     = -1.f;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (uint i = 0; i < count; i++)
+        if (durations[i] >= 0.f) addSample(data.scopes[i], durations[i]);
+    data.scopes.clear();
+}
+
+// Only once the device is idle, e.g. before reading the final statistics
+void GPUProfiler::collectAll() {
+    for (uint slot = 0; slot < m_slots.size(); slot++) collect(slot);
+}
+
+// Resets every query of the current slot, recorded outside a render pass
+// before the first scope
+void GPUProfiler::cmdReset(VkCommandBuffer cmdBuffer) {
+    if (!m_enabled) return;
+    vkCmdResetQueryPool(cmdBuffer, m_slots[m_slot].queryPool, 0, m_maxScopes * 2);
+}
+
+void GPUProfiler::cmdReset(VkCommandBuffer cmdBuffer, uint scope) {
+    if (scope == PROFILER_NO_SCOPE) return;
+    vkCmdResetQueryPool(cmdBuffer, m_slots[m_slot].queryPool, scope * 2, 2);
+}
+
+// Reserved on the recording thread of the primary, so a worker can write the
+// timestamps of the scope into its secondary
+uint GPUProfiler::addScope(const STRING& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    VECTOR<STRING>& scopes = m_slots[m_slot].scopes;
+    if (!m_enabled || scopes.size() >= m_maxScopes) return PROFILER_NO_SCOPE;
+    scopes.push_back(name);
+    return UINT32(scopes.size() - 1);
+}
+
+uint GPUProfiler::cmdBegin(VkCommandBuffer cmdBuffer, const STRING& name) {
+    uint scope = addScope(name);
+    cmdBegin(cmdBuffer, scope);
+    return scope;
+}
+
+void GPUProfiler::cmdBegin(VkCommandBuffer cmdBuffer, uint scope) {
+    if (scope == PROFILER_NO_SCOPE) return;
+    vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        m_slots[m_slot].queryPool, scope * 2);
+}
+
+void GPUProfiler::cmdEnd(VkCommandBuffer cmdBuffer, uint scope) {
+    if (scope == PROFILER_NO_SCOPE) return;
+    vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        m_slots[m_slot].queryPool, scope * 2 + 1);
+}
+
+const STRING& GPUProfiler::getName() { return m_name; }
+
+VECTOR<GPUProfiler::ScopeStats> GPUProfiler::getStats() {
+    VECTOR<ScopeStats> stats;
+    getStats(&stats);
+    return stats;
+}
+
+// Refills the given list in place, a list kept by the caller stops
+// allocating once it has held every scope's full history
+void GPUProfiler::getStats(VECTOR<ScopeStats>* pStats) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    VECTOR<float>& sorted = m_sorted;
+    pStats->resize(m_names.size());
+    for (uint i = 0; i < m_names.size(); i++) {
+        History&    history = m_histories[m_names[i]];
+        ScopeStats& scope   = (*pStats)[i];
+        scope.name  = m_names[i];
+        scope.total = history.total;
+        scope.history.clear();
+        for (uint j = 0; j < history.count; j++) {
+            uint idx = (history.next + PROFILER_HISTORY - history.count + j) % PROFILER_HISTORY;
+            scope.history.push_back(history.samples[idx]);
+        }
+        
+        sorted.assign(scope.history.begin(), scope.history.end());
+        std::sort(sorted.begin(), sorted.end());
+        float total = 0.f;
+        for (float sample : sorted) total += sample;
+        scope.last = scope.history.back();
+        scope.min  = sorted.front();
+        scope.avg  = total / sorted.size();
+        scope.p99  = sorted[(sorted.size() * 99 + 99) / 100 - 1];
+    }
+}
+
+// Private ==================================================
+
+void GPUProfiler::addSample(const STRING& name, float duration) {
+    History& history = m_histories[name];
+    if (history.samples.empty()) {
+        history.samples.resize(PROFILER_HISTORY, 0.f);
+        m_names.push_back(name);
+    }
+    history.samples[history.next] = duration;
+    history.next  = (history.next + 1) % PROFILER_HISTORY;
+    history.count = std::min(history.count + 1, (uint)PROFILER_HISTORY);
+    history.total++;
+}
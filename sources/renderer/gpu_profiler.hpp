@@ -0,0 +1,90 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "device.hpp"
+
+#include <mutex>
+
+#define PROFILER_HISTORY  128
+#define PROFILER_NO_SCOPE UINT32_MAX
+
+// Timestamp pairs around named scopes of one command stream. Every slot owns a
+// query pool and is only reused once its submission has completed, so results
+// are read back without waiting. Scopes recorded more than once in a slot are
+// summed. The last PROFILER_HISTORY durations of every scope are kept.
+class GPUProfiler {
+    
+    // Results and durations are sized once, collecting reuses them
+    struct Slot {
+        VkQueryPool      queryPool = VK_NULL_HANDLE;
+        VECTOR<STRING>   scopes;
+        VECTOR<uint64_t> results;
+        VECTOR<float>    durations;
+    };
+    
+    struct History {
+        VECTOR<float> samples;
+        uint next  = 0;
+        uint count = 0;
+        uint64_t total = 0;
+    };
+    
+public:
+    struct ScopeStats {
+        STRING        name;
+        VECTOR<float> history; // Oldest first, in ms
+        float last = 0.f;
+        float min  = 0.f;
+        float avg  = 0.f;
+        float p99  = 0.f;
+        uint64_t total = 0; // Samples ever taken, the history keeps the last ones
+    };
+    
+    ~GPUProfiler();
+    GPUProfiler();
+    
+    void cleanup();
+    
+    void setup(STRING name, uint32_t queueFamilyIndex, uint slotCount, uint maxScopes);
+    void create();
+    
+    void beginFrame(uint slot);
+    void collect(uint slot);
+    void collectAll();
+    
+    void cmdReset(VkCommandBuffer cmdBuffer);
+    void cmdReset(VkCommandBuffer cmdBuffer, uint scope);
+    uint addScope(const STRING& name);
+    uint cmdBegin(VkCommandBuffer cmdBuffer, const STRING& name);
+    void cmdBegin(VkCommandBuffer cmdBuffer, uint scope);
+    void cmdEnd  (VkCommandBuffer cmdBuffer, uint scope);
+    
+    const STRING& getName();
+    VECTOR<ScopeStats> getStats();
+    void getStats(VECTOR<ScopeStats>* pStats);
+    
+private:
+    Cleaner m_cleaner;
+    Device* m_pDevice;
+    
+    STRING   m_name;
+    bool     m_enabled   = false;
+    float    m_period    = 1.f;
+    uint32_t m_maxScopes = 0;
+    uint     m_slot      = 0;
+    
+    VECTOR<Slot> m_slots;
+    
+    // Guards scope reservation and the histories, which the GUI reads while
+    // other threads collect
+    std::mutex m_mutex;
+    VECTOR<STRING> m_names;
+    std::map<STRING, History> m_histories;
+    VECTOR<float> m_sorted;
+    
+    void addSample(const STRING& name, float duration);
+    
+};
@@ -0,0 +1,193 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "recorder.hpp"
+
+#include "../system.hpp"
+
+Recorder::~Recorder() {}
+Recorder::Recorder() : m_pDevice(System::Device()) {}
+
+void Recorder::cleanup() { m_cleaner.flush("Recorder"); }
+
+// Job storage is reserved up front, so jobs stay in place while others are
+// added and recording a frame allocates nothing
+void Recorder::setup(uint threadCount) {
+    m_threadCount = threadCount > 0 ? threadCount : 1;
+    m_workers = VECTOR<Worker>(m_threadCount);
+    m_jobs.reserve(RECORDER_MAX_JOBS);
+    for (Worker& worker : m_workers) worker.jobs.reserve(RECORDER_MAX_JOBS);
+}
+
+void Recorder::create() {
+    LOG("Recorder::create");
+    VkDevice device = m_pDevice->getDevice();
+    
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = m_pDevice->getGraphicQueueIndex();
+    
+    for (Worker& worker : m_workers) {
+        worker.commandPools.resize(MAX_FRAMES_IN_FLIGHT);
+        worker.cmdBuffers  .resize(MAX_FRAMES_IN_FLIGHT);
+        for (VkCommandPool& commandPool : worker.commandPools) {
+            VkResult result = vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool);
+            CHECK_VKRESULT(result, "failed to create recorder command pool!");
+        }
+    }
+    m_cleaner.push([=](){
+        for (Worker& worker : m_workers)
+            for (VkCommandPool commandPool : worker.commandPools)
+                vkDestroyCommandPool(device, commandPool, nullptr);
+    });
+    
+    for (uint i = 0; i < m_threadCount; i++)
+        m_workers[i].thread = std::thread(&Recorder::work, this, i);
+    m_cleaner.push([=](){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_workCondition.notify_all();
+        for (Worker& worker : m_workers) worker.thread.join();
+    });
+}
+
+// The frame's previous submission has completed, so its pools are reset as
+// a whole and the buffers recorded again. Every job of the last frame must
+// have been waited on.
+void Recorder::beginFrame(uint frameIdx) {
+    VkDevice device = m_pDevice->getDevice();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frameIdx = frameIdx;
+    m_jobs.clear();
+    for (Worker& worker : m_workers) {
+        vkResetCommandPool(device, worker.commandPools[frameIdx], 0);
+        worker.jobs.clear();
+        worker.nextJob   = 0;
+        worker.usedCount = 0;
+    }
+}
+
+// Records a secondary command buffer continuing the given render pass
+uint Recorder::record(VkRenderPass renderpass, VkFramebuffer framebuffer, RecordFunc record) {
+    Job job{};
+    job.record      = std::move(record);
+    job.renderpass  = renderpass;
+    job.framebuffer = framebuffer;
+    return submit(job);
+}
+
+// Runs a task that records into command buffers of its own, e.g. the
+// primary of another queue
+uint Recorder::run(TaskFunc task) {
+    Job job{};
+    job.task = std::move(task);
+    return submit(job);
+}
+
+VkCommandBuffer Recorder::wait(uint job) {
+    TRACE_SCOPE("wait job");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [=](){ return m_jobs[job].done; });
+    return m_jobs[job].cmdBuffer;
+}
+
+void Recorder::waitAll() {
+    TRACE_SCOPE("wait jobs");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [=](){
+        for (Job& job : m_jobs)
+            if (!job.done) return false;
+        return true;
+    });
+}
+
+// Private ==================================================
+
+uint Recorder::submit(Job& job) {
+    uint jobIdx;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        jobIdx = UINT32(m_jobs.size());
+        if (jobIdx >= RECORDER_MAX_JOBS) RUNTIME_ERROR("too many recorder jobs in one frame!");
+        m_jobs.push_back(std::move(job));
+        m_workers[jobIdx % m_threadCount].jobs.push_back(jobIdx);
+    }
+    m_workCondition.notify_all();
+    return jobIdx;
+}
+
+void Recorder::work(uint workerIdx) {
+    Worker& worker = m_workers[workerIdx];
+    Tracer::setThreadName("recorder " + std::to_string(workerIdx));
+    while (true) {
+        // The container is only read under the lock, the reserved storage
+        // then keeps the job in place while others are pushed
+        Job* pJob;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workCondition.wait(lock, [&](){ return m_stopping || worker.nextJob < worker.jobs.size(); });
+            if (worker.nextJob == worker.jobs.size()) return;
+            pJob = &m_jobs[worker.jobs[worker.nextJob++]];
+        }
+        
+        Job& job = *pJob;
+        {
+            TRACE_SCOPE("record job");
+            if (job.task) job.task();
+            else recordSecondary(worker, job);
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            job.done = true;
+        }
+        m_doneCondition.notify_all();
+    }
+}
+
+void Recorder::recordSecondary(Worker& worker, Job& job) {
+    VkCommandBuffer cmdBuffer = nextCommandBuffer(worker);
+    
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass  = job.renderpass;
+    inheritanceInfo.subpass     = 0;
+    inheritanceInfo.framebuffer = job.framebuffer;
+    
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (job.renderpass != VK_NULL_HANDLE)
+        beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    
+    VkResult result = vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+    CHECK_VKRESULT(result, "failed to begin recording secondary command buffer!");
+    job.record(cmdBuffer);
+    vkEndCommandBuffer(cmdBuffer);
+    job.cmdBuffer = cmdBuffer;
+}
+
+// Buffers are kept per frame and reused, new ones are only allocated when a
+// frame records more jobs on this worker than any frame before
+VkCommandBuffer Recorder::nextCommandBuffer(Worker& worker) {
+    VkDevice device = m_pDevice->getDevice();
+    VECTOR<VkCommandBuffer>& cmdBuffers = worker.cmdBuffers[m_frameIdx];
+    
+    if (worker.usedCount == cmdBuffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandPool = worker.commandPools[m_frameIdx];
+        allocInfo.commandBufferCount = 1;
+        
+        VkCommandBuffer cmdBuffer;
+        VkResult result = vkAllocateCommandBuffers(device, &allocInfo, &cmdBuffer);
+        CHECK_VKRESULT(result, "failed to allocate secondary command buffer!");
+        cmdBuffers.push_back(cmdBuffer);
+    }
+    return cmdBuffers[worker.usedCount++];
+}
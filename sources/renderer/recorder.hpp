@@ -0,0 +1,77 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "device.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define RECORDER_MAX_JOBS 32 // Per frame, the job storage never grows
+
+// Worker threads recording command buffers in parallel with the main thread.
+// Each worker owns one command pool per frame in flight on the graphic
+// family, secondary buffers come from the pool of the worker recording them.
+// Jobs are handed out round robin and waited on by index.
+class Recorder {
+    
+    typedef std::function<void(VkCommandBuffer)> RecordFunc;
+    typedef std::function<void()>                TaskFunc;
+    
+    struct Job {
+        RecordFunc      record;
+        TaskFunc        task;
+        VkRenderPass    renderpass  = VK_NULL_HANDLE;
+        VkFramebuffer   framebuffer = VK_NULL_HANDLE;
+        VkCommandBuffer cmdBuffer   = VK_NULL_HANDLE;
+        bool            done        = false;
+    };
+    
+    struct Worker {
+        std::thread      thread;
+        VECTOR<uint>     jobs;
+        uint             nextJob   = 0;
+        VECTOR<VkCommandPool>           commandPools;
+        VECTOR<VECTOR<VkCommandBuffer>> cmdBuffers;
+        uint             usedCount = 0;
+    };
+    
+public:
+    ~Recorder();
+    Recorder();
+    
+    void cleanup();
+    
+    void setup(uint threadCount);
+    void create();
+    
+    void beginFrame(uint frameIdx);
+    uint record(VkRenderPass renderpass, VkFramebuffer framebuffer, RecordFunc record);
+    uint run(TaskFunc task);
+    VkCommandBuffer wait(uint job);
+    void waitAll();
+    
+private:
+    Cleaner m_cleaner;
+    Device* m_pDevice;
+    
+    uint m_threadCount = 1;
+    uint m_frameIdx    = 0;
+    bool m_stopping    = false;
+    
+    VECTOR<Worker> m_workers;
+    VECTOR<Job>    m_jobs;
+    
+    std::mutex              m_mutex;
+    std::condition_variable m_workCondition;
+    std::condition_variable m_doneCondition;
+    
+    uint submit(Job& job);
+    void work(uint workerIdx);
+    void recordSecondary(Worker& worker, Job& job);
+    VkCommandBuffer nextCommandBuffer(Worker& worker);
+    
+};
@@ -0,0 +1,228 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "render_graph.hpp"
+
+#include "../system.hpp"
+
+#include <algorithm>
+
+#define WRITE_ACCESS_MASK (VK_ACCESS_SHADER_WRITE_BIT | \
+                           VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | \
+                           VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | \
+                           VK_ACCESS_TRANSFER_WRITE_BIT | \
+                           VK_ACCESS_HOST_WRITE_BIT | \
+                           VK_ACCESS_MEMORY_WRITE_BIT)
+
+RenderGraph::~RenderGraph() {}
+RenderGraph::RenderGraph() : m_pDevice(System::Device()) {}
+
+void RenderGraph::cleanup() { m_cleaner.flush("RenderGraph"); }
+
+void RenderGraph::setupPasses(VECTOR<STRING> passNames) {
+    m_passes.resize(passNames.size());
+    for (uint i = 0; i < passNames.size(); i++)
+        m_passes[i].name = passNames[i];
+    
+    m_pArena = new ScratchArena();
+    m_pArena->setMemoryTag(MEMORY_TAG_FRAME);
+    m_cleaner.push([=](){ m_pArena->cleanup(); });
+}
+
+// Every live pass is timed under its name, after its barriers
+void RenderGraph::setProfiler(GPUProfiler* pProfiler) { m_pProfiler = pProfiler; }
+
+// Transient images live in the graph's aliased pool between the two passes.
+// The image only needs to be set up; it is usable after createTransients().
+void RenderGraph::addTransient(Image* pImage, STRING firstPass, STRING lastPass) {
+    m_pArena->addImage(pImage, findPass(firstPass), findPass(lastPass));
+    m_transients.push_back(pImage);
+}
+
+void RenderGraph::createTransients() { m_pArena->create(); }
+
+void RenderGraph::releaseTransients() {
+    for (Image* pImage : m_transients) m_imageStates.erase(pImage);
+    m_transients.clear();
+    m_pArena->release();
+}
+
+void RenderGraph::reset() {
+    for (Pass& pass : m_passes) {
+        pass.added  = false;
+        pass.live   = false;
+        pass.record = nullptr;
+        pass.images .clear();
+        pass.buffers.clear();
+    }
+    m_exports.clear();
+}
+
+uint RenderGraph::addPass(STRING name, RecordFunc record, bool enabled) {
+    uint idx = findPass(name);
+    Pass& pass   = m_passes[idx];
+    pass.added   = true;
+    pass.enabled = enabled;
+    pass.root    = false;
+    pass.record  = record;
+    return idx;
+}
+
+// Root passes have effects outside the graph, e.g. drawing to the swapchain
+void RenderGraph::setRoot(uint pass) { m_passes[pass].root = true; }
+
+void RenderGraph::readImage(uint pass, Image* pImage, VkImageLayout layout,
+                            VkAccessFlags access, VkPipelineStageFlags stage) {
+    m_passes[pass].images.push_back({ pImage, layout, access, stage, false });
+}
+
+// Discarded images start from an undefined layout, their old content is dropped
+void RenderGraph::writeImage(uint pass, Image* pImage, VkImageLayout layout,
+                             VkAccessFlags access, VkPipelineStageFlags stage, bool discard) {
+    m_passes[pass].images.push_back({ pImage, layout, access, stage, discard });
+}
+
+void RenderGraph::readBuffer(uint pass, Buffer* pBuffer, VkAccessFlags access, VkPipelineStageFlags stage) {
+    m_passes[pass].buffers.push_back({ pBuffer, access, stage });
+}
+
+void RenderGraph::writeBuffer(uint pass, Buffer* pBuffer, VkAccessFlags access, VkPipelineStageFlags stage) {
+    m_passes[pass].buffers.push_back({ pBuffer, access, stage });
+}
+
+// Images used after the graph, by the next frame or another queue. They keep
+// the passes writing them alive and end up in the given layout.
+void RenderGraph::exportImage(Image* pImage, VkImageLayout layout,
+                              VkAccessFlags access, VkPipelineStageFlags stage) {
+    m_exports.push_back({ pImage, layout, access, stage, false });
+}
+
+// Walks the passes backwards: a pass is live when it is enabled and either a
+// root or writes something a later live pass or an export reads. The needed
+// resources are few, they are kept in a list reused across frames.
+void RenderGraph::compile() {
+    TRACE_SCOPE("compile graph");
+    VECTOR<const void*>& needed = m_needed;
+    needed.clear();
+    for (ImageUse& use : m_exports) needed.push_back(use.pImage);
+    
+    for (int i = static_cast<int>(m_passes.size()) - 1; i >= 0; i--) {
+        Pass& pass = m_passes[i];
+        pass.live = false;
+        if (!pass.added || !pass.enabled) continue;
+    
+        bool live = pass.root;
+        for (ImageUse& use : pass.images)
+            if (IsWrite(use.access) && isNeeded(use.pImage)) live = true;
+        for (BufferUse& use : pass.buffers)
+            if (IsWrite(use.access) && isNeeded(use.pBuffer)) live = true;
+        if (!live) continue;
+    
+        pass.live = true;
+        for (ImageUse& use : pass.images)
+            if (!use.discard) needed.push_back(use.pImage);
+        for (BufferUse& use : pass.buffers)
+            needed.push_back(use.pBuffer);
+    }
+}
+
+void RenderGraph::execute(VkCommandBuffer cmdBuffer) {
+    TRACE_SCOPE("execute graph");
+    for (Pass& pass : m_passes) {
+        if (!pass.live) continue;
+        for (ImageUse& use : pass.images)
+            addImageBarrier(use, IsWrite(use.access));
+        for (BufferUse& use : pass.buffers)
+            addBufferBarrier(use, IsWrite(use.access));
+        m_batch.flush(cmdBuffer);
+        
+        uint scope = m_pProfiler ? m_pProfiler->cmdBegin(cmdBuffer, pass.name) : PROFILER_NO_SCOPE;
+        pass.record(cmdBuffer);
+        if (m_pProfiler) m_pProfiler->cmdEnd(cmdBuffer, scope);
+    }
+    for (ImageUse& use : m_exports)
+        addImageBarrier(use, false);
+    m_batch.flush(cmdBuffer);
+}
+
+bool RenderGraph::hasWork() {
+    for (Pass& pass : m_passes)
+        if (pass.live) return true;
+    return false;
+}
+
+bool RenderGraph::isLive(STRING name) { return m_passes[findPass(name)].live; }
+
+// Private ==================================================
+
+bool RenderGraph::isNeeded(const void* pResource) {
+    return std::find(m_needed.begin(), m_needed.end(), pResource) != m_needed.end();
+}
+
+uint RenderGraph::findPass(const STRING& name) {
+    for (uint i = 0; i < m_passes.size(); i++)
+        if (m_passes[i].name == name) return i;
+    RUNTIME_ERROR("render graph pass " + name + " was not set up!");
+}
+
+// Reads only wait when the last write is not yet visible to them; writes and
+// layout changes wait for every earlier reader and writer.
+void RenderGraph::addImageBarrier(const ImageUse& use, bool write) {
+    AccessState&  state     = m_imageStates[use.pImage];
+    VkImageLayout oldLayout = use.pImage->getImageLayout();
+    bool layoutChange = oldLayout != use.layout;
+    bool covered = (state.readStage & use.stage) == use.stage &&
+                   (state.readAccess & use.access) == use.access;
+    
+    if (!write && !layoutChange) {
+        bool pending = state.writeStage != 0 && !covered;
+        if (pending) {
+            use.pImage->addLayoutChange(&m_batch, oldLayout,
+                                        state.writeAccess, use.access,
+                                        state.writeStage, use.stage);
+        }
+        state.readAccess |= use.access;
+        state.readStage  |= use.stage;
+        return;
+    }
+    
+    bool untouched = state.writeStage == 0 && state.readStage == 0;
+    if (layoutChange || !untouched) {
+        use.pImage->addLayoutChange(&m_batch, use.layout,
+                                    state.writeAccess, use.access,
+                                    state.writeStage | state.readStage, use.stage,
+                                    use.discard);
+    }
+    
+    // A layout change alone chains later readers through its stage
+    state.writeAccess = use.access & WRITE_ACCESS_MASK;
+    state.writeStage  = use.stage;
+    state.readAccess  = write ? 0 : use.access;
+    state.readStage   = write ? 0 : use.stage;
+}
+
+void RenderGraph::addBufferBarrier(const BufferUse& use, bool write) {
+    AccessState& state = m_bufferStates[use.pBuffer];
+    bool covered = (state.readStage & use.stage) == use.stage &&
+                   (state.readAccess & use.access) == use.access;
+    
+    VkPipelineStageFlags srcStage = 0;
+    if (!write && state.writeStage != 0 && !covered) srcStage = state.writeStage;
+    if ( write) srcStage = state.writeStage | state.readStage;
+    
+    if (srcStage) {
+        use.pBuffer->addBarrier(&m_batch, state.writeAccess, use.access, srcStage, use.stage);
+    }
+    
+    if (write) {
+        state.writeAccess = use.access & WRITE_ACCESS_MASK;
+        state.writeStage  = use.stage;
+        state.readAccess  = 0;
+        state.readStage   = 0;
+    } else {
+        state.readAccess |= use.access;
+        state.readStage  |= use.stage;
+    }
+}
+
+bool RenderGraph::IsWrite(VkAccessFlags access) { return access & WRITE_ACCESS_MASK; }
@@ -0,0 +1,111 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "device.hpp"
+#include "barrier_batch.hpp"
+#include "gpu_profiler.hpp"
+#include "../resources/image.hpp"
+#include "../resources/buffer.hpp"
+#include "../resources/scratch_arena.hpp"
+
+// Frame graph for one command buffer. The pass order is fixed at setup; every
+// frame the passes are added again with the resources they read and write.
+// compile() culls passes that are disabled or whose results nobody consumes,
+// execute() records the live ones with one batched barrier in front of each,
+// every barrier in it carrying its own stage and access masks.
+class RenderGraph {
+
+    typedef std::function<void(VkCommandBuffer)> RecordFunc;
+    
+    struct ImageUse {
+        Image*               pImage;
+        VkImageLayout        layout;
+        VkAccessFlags        access;
+        VkPipelineStageFlags stage;
+        bool                 discard;
+    };
+    
+    struct BufferUse {
+        Buffer*              pBuffer;
+        VkAccessFlags        access;
+        VkPipelineStageFlags stage;
+    };
+    
+    struct Pass {
+        STRING     name;
+        RecordFunc record;
+        bool added   = false;
+        bool enabled = false;
+        bool root    = false;
+        bool live    = false;
+        VECTOR<ImageUse>  images;
+        VECTOR<BufferUse> buffers;
+    };
+    
+    // Last write not yet made visible, and the readers since that write
+    struct AccessState {
+        VkAccessFlags        writeAccess  = 0;
+        VkPipelineStageFlags writeStage   = 0;
+        VkAccessFlags        readAccess   = 0;
+        VkPipelineStageFlags readStage    = 0;
+    };
+
+public:
+    ~RenderGraph();
+    RenderGraph();
+    
+    void cleanup();
+    
+    void setupPasses(VECTOR<STRING> passNames);
+    void setProfiler(GPUProfiler* pProfiler);
+    
+    void addTransient(Image* pImage, STRING firstPass, STRING lastPass);
+    void createTransients();
+    void releaseTransients();
+    
+    void reset();
+    uint addPass(STRING name, RecordFunc record, bool enabled = true);
+    void setRoot(uint pass);
+    
+    void readImage  (uint pass, Image* pImage, VkImageLayout layout,
+                     VkAccessFlags access, VkPipelineStageFlags stage);
+    void writeImage (uint pass, Image* pImage, VkImageLayout layout,
+                     VkAccessFlags access, VkPipelineStageFlags stage, bool discard = false);
+    void readBuffer (uint pass, Buffer* pBuffer, VkAccessFlags access, VkPipelineStageFlags stage);
+    void writeBuffer(uint pass, Buffer* pBuffer, VkAccessFlags access, VkPipelineStageFlags stage);
+    void exportImage(Image* pImage, VkImageLayout layout,
+                     VkAccessFlags access, VkPipelineStageFlags stage);
+    
+    void compile();
+    void execute(VkCommandBuffer cmdBuffer);
+    
+    bool hasWork();
+    bool isLive(STRING name);
+
+private:
+    Cleaner m_cleaner;
+    Device* m_pDevice;
+    ScratchArena* m_pArena;
+    GPUProfiler*  m_pProfiler = nullptr;
+    
+    VECTOR<Pass>     m_passes;
+    VECTOR<ImageUse> m_exports;
+    VECTOR<const void*> m_needed;
+    
+    std::map<Image*,  AccessState> m_imageStates;
+    std::map<Buffer*, AccessState> m_bufferStates;
+    VECTOR<Image*> m_transients;
+    
+    BarrierBatch m_batch;
+    
+    uint findPass(const STRING& name);
+    bool isNeeded(const void* pResource);
+    void addImageBarrier (const ImageUse& use, bool write);
+    void addBufferBarrier(const BufferUse& use, bool write);
+    
+    static bool IsWrite(VkAccessFlags access);
+
+};
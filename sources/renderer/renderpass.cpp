@@ -10,7 +10,7 @@ Renderpass::Renderpass() : m_pDevice(System::Device()) {}
 
 void Renderpass::cleanup() { m_cleaner.flush("Renderpass"); }
 
-void Renderpass::setupColorAttachment(VkFormat format) {
+void Renderpass::setupColorAttachment(VkFormat format, VkImageLayout finalLayout) {
     VkAttachmentDescription colorAttachment{};
     colorAttachment.format          = format;
     colorAttachment.samples         = VK_SAMPLE_COUNT_1_BIT;
@@ -19,7 +19,7 @@ void Renderpass::setupColorAttachment(VkFormat format) {
     colorAttachment.stencilLoadOp   = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp  = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout   = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout     = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout     = finalLayout;
     
     m_attachments.push_back(colorAttachment);
     
@@ -59,6 +59,13 @@ void Renderpass::setup() {
     m_dependency.dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     m_dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
     
+    // Depth is cleared every pass, so the clear has to wait for the last pass' tests
+    if (m_subpass.pDepthStencilAttachment) {
+        m_dependency.srcStageMask  |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        m_dependency.dstStageMask  |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        m_dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
+    
     m_renderpassInfo.sType            = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     m_renderpassInfo.attachmentCount  = UINT32(m_attachments.size());
     m_renderpassInfo.pAttachments     = m_attachments.data();
@@ -13,7 +13,8 @@ public:
     Renderpass();
     
     void cleanup();
-    void setupColorAttachment(VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
+    void setupColorAttachment(VkFormat format = VK_FORMAT_R8G8B8A8_UNORM,
+                              VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
     void setupDepthAttachment(VkFormat format = VK_FORMAT_D24_UNORM_S8_UINT);
     void setup();
     void create();
@@ -0,0 +1,108 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "stall_auditor.hpp"
+
+#include <algorithm>
+
+// Stalls cost far more than the lock, a shared table keeps the report simple
+void StallAuditor::record(Kind kind, TimeVal start, TimeVal end) {
+    Sites& sites = ThreadSites();
+    float  ms    = TimeDif(end - start).count() * 1000.f;
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    AddSample(state.sites[Key{kind, sites.outer, sites.inner}], ms);
+    AddSample(state.frame.kinds[kind], ms);
+}
+
+// Called once per frame by the frame loop, calls from every thread count
+void StallAuditor::endFrame() {
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.lastFrame = state.frame;
+    state.frame     = FrameStats();
+    state.frameCount++;
+}
+
+StallAuditor::FrameStats StallAuditor::getLastFrame() {
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.lastFrame;
+}
+
+// Logs every site since the previous report, the longest total first, and
+// starts over
+void StallAuditor::report(const char* title) {
+    State& state = GetState();
+    VECTOR<std::pair<Key, Stats>> sites;
+    uint64_t frameCount;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        sites.assign(state.sites.begin(), state.sites.end());
+        frameCount = state.frameCount;
+        state.sites.clear();
+        state.frameCount = 0;
+    }
+    std::sort(sites.begin(), sites.end(), [](const std::pair<Key, Stats>& a, const std::pair<Key, Stats>& b) {
+        return a.second.ms > b.second.ms;
+    });
+    
+    LOG("StallAuditor::report " << title << ", " << frameCount << " frames");
+    for (auto& site : sites) {
+        const Key&   key   = site.first;
+        const Stats& stats = site.second;
+        bool nested = key.inner != key.outer;
+        char line[LOGGER_LINE_SIZE];
+        snprintf(line, sizeof(line), "%-18s %7llu calls %10.3f ms max %8.3f ms  %s%s%s",
+                 kindName(key.kind), (unsigned long long) stats.count, stats.ms, stats.maxMs,
+                 key.outer ? key.outer : "-", nested ? " > " : "", nested ? key.inner : "");
+        LOG(line);
+    }
+}
+
+const char* StallAuditor::kindName(Kind kind) {
+    switch (kind) {
+        case Submit           : return "vkQueueSubmit";
+        case Wait             : return "vkWaitSemaphores";
+        case QueueWaitIdle    : return "vkQueueWaitIdle";
+        case DeviceWaitIdle   : return "vkDeviceWaitIdle";
+        case AllocateMemory   : return "vkAllocateMemory";
+        case UpdateDescriptors: return "vkUpdateDescriptorSets";
+        case Acquire          : return "vkAcquireNextImageKHR";
+        case Present          : return "vkQueuePresentKHR";
+        default               : return "unknown";
+    }
+}
+
+// Returns the innermost site before this one, for StallSite to restore
+const char* StallAuditor::enterSite(const char* name) {
+    Sites&      sites    = ThreadSites();
+    const char* previous = sites.inner;
+    if (!sites.outer) sites.outer = name;
+    sites.inner = name;
+    return previous;
+}
+
+void StallAuditor::leaveSite(const char* previous) {
+    Sites& sites = ThreadSites();
+    sites.inner = previous;
+    if (!previous) sites.outer = nullptr;
+}
+
+// Private ==================================================
+
+StallAuditor::State& StallAuditor::GetState() {
+    static State state;
+    return state;
+}
+
+StallAuditor::Sites& StallAuditor::ThreadSites() {
+    static thread_local Sites sites;
+    return sites;
+}
+
+void StallAuditor::AddSample(Stats& stats, float ms) {
+    stats.count++;
+    stats.ms   += ms;
+    stats.maxMs = std::max(stats.maxMs, ms);
+}
@@ -0,0 +1,98 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "../tracer.hpp"
+
+#include <mutex>
+#include <tuple>
+
+#define STALL_SITE(name)  StallSite  TRACE_CONCAT(stallSite,  __LINE__)(name)
+#define STALL_SCOPE(kind) StallScope TRACE_CONCAT(stallScope, __LINE__)(StallAuditor::kind)
+
+// Calls into Vulkan that may block the CPU, counted and timed per frame and
+// per call site. A site is the outermost and innermost STALL_SITE active on
+// the calling thread, e.g. a texture reload waiting through the commander.
+// Timeline waits stand in for fence waits, the renderer has no fences.
+class StallAuditor {
+
+public:
+    enum Kind { Submit, Wait, QueueWaitIdle, DeviceWaitIdle, AllocateMemory, UpdateDescriptors,
+                Acquire, Present, KindCount };
+    
+    struct Stats {
+        uint64_t count = 0;
+        float    ms    = 0.f;
+        float    maxMs = 0.f;
+    };
+    
+    struct FrameStats {
+        Stats kinds[KindCount];
+    };
+    
+    static void record(Kind kind, TimeVal start, TimeVal end);
+    static void endFrame();
+    static FrameStats getLastFrame();
+    static void report(const char* title);
+    static const char* kindName(Kind kind);
+    
+    static const char* enterSite(const char* name);
+    static void leaveSite(const char* previous);
+
+private:
+    struct Key {
+        Kind        kind;
+        const char* outer;
+        const char* inner;
+        bool operator<(const Key& other) const {
+            return std::tie(kind, outer, inner) < std::tie(other.kind, other.outer, other.inner);
+        }
+    };
+    
+    struct Sites {
+        const char* outer = nullptr;
+        const char* inner = nullptr;
+    };
+    
+    // Totals since the last report, and of the frame being recorded
+    struct State {
+        std::mutex           mutex;
+        std::map<Key, Stats> sites;
+        FrameStats           frame;
+        FrameStats           lastFrame;
+        uint64_t             frameCount = 0;
+    };
+    
+    static State& GetState();
+    static Sites& ThreadSites();
+    static void AddSample(Stats& stats, float ms);
+
+};
+
+// Names the calls made until the end of the enclosing block. The name must
+// outlive the auditor, string literals are expected.
+class StallSite {
+
+public:
+    ~StallSite() { StallAuditor::leaveSite(m_previous); }
+    StallSite(const char* name) : m_previous(StallAuditor::enterSite(name)) {}
+
+private:
+    const char* m_previous;
+
+};
+
+// Times the Vulkan call made in the enclosing block
+class StallScope {
+
+public:
+    ~StallScope() { StallAuditor::record(m_kind, m_start, ChronoTime::now()); }
+    StallScope(StallAuditor::Kind kind) : m_kind(kind), m_start(ChronoTime::now()) {}
+
+private:
+    StallAuditor::Kind m_kind;
+    TimeVal            m_start;
+
+};
@@ -0,0 +1,69 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "static_commands.hpp"
+
+#include "../system.hpp"
+
+StaticCommands::~StaticCommands() {}
+StaticCommands::StaticCommands() : m_pDevice(System::Device()) {}
+
+void StaticCommands::cleanup() { m_cleaner.flush("StaticCommands"); }
+
+void StaticCommands::setup(VkRenderPass renderpass, uint variantCount) {
+    m_renderpass = renderpass;
+    m_cmdBuffers.resize(variantCount);
+    m_recorded  .resize(variantCount, false);
+}
+
+void StaticCommands::create() {
+    LOG("StaticCommands::create");
+    VkDevice device = m_pDevice->getDevice();
+    
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = m_pDevice->getGraphicQueueIndex();
+    VkResult result = vkCreateCommandPool(device, &poolInfo, nullptr, &m_commandPool);
+    CHECK_VKRESULT(result, "failed to create static command pool!");
+    m_cleaner.push([=](){ vkDestroyCommandPool(device, m_commandPool, nullptr); });
+    
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.commandBufferCount = UINT32(m_cmdBuffers.size());
+    result = vkAllocateCommandBuffers(device, &allocInfo, m_cmdBuffers.data());
+    CHECK_VKRESULT(result, "failed to allocate static command buffers!");
+}
+
+void StaticCommands::invalidate() {
+    for (uint i = 0; i < m_recorded.size(); i++) m_recorded[i] = false;
+}
+
+// The framebuffer is left out of the inheritance, so the same recording
+// serves every framebuffer of the render pass
+VkCommandBuffer StaticCommands::get(uint variant, RecordFunc record) {
+    VkCommandBuffer cmdBuffer = m_cmdBuffers[variant];
+    if (m_recorded[variant]) return cmdBuffer;
+    
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass  = m_renderpass;
+    inheritanceInfo.subpass     = 0;
+    inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+    
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    
+    vkResetCommandBuffer(cmdBuffer, 0);
+    VkResult result = vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+    CHECK_VKRESULT(result, "failed to begin recording static command buffer!");
+    record(cmdBuffer);
+    vkEndCommandBuffer(cmdBuffer);
+    
+    m_recorded[variant] = true;
+    return cmdBuffer;
+}
@@ -0,0 +1,40 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "device.hpp"
+
+// Secondary command buffers for draws that record the same commands every
+// frame. Each variant, usually one per frame in flight, is recorded once and
+// executed as is until invalidate() is called because an input changed.
+// A variant is only re-recorded when it is requested, which must happen
+// after its previous submission has completed.
+class StaticCommands {
+    
+    typedef std::function<void(VkCommandBuffer)> RecordFunc;
+    
+public:
+    ~StaticCommands();
+    StaticCommands();
+    
+    void cleanup();
+    
+    void setup(VkRenderPass renderpass, uint variantCount);
+    void create();
+    
+    void invalidate();
+    VkCommandBuffer get(uint variant, RecordFunc record);
+    
+private:
+    Cleaner m_cleaner;
+    Device* m_pDevice;
+    
+    VkRenderPass  m_renderpass  = VK_NULL_HANDLE;
+    VkCommandPool m_commandPool = VK_NULL_HANDLE;
+    
+    VECTOR<VkCommandBuffer> m_cmdBuffers;
+    VECTOR<bool>            m_recorded;
+    
+};
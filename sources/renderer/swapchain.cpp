@@ -6,12 +6,14 @@
 #include "../system.hpp"
 
 Swapchain::~Swapchain() {}
-Swapchain::Swapchain() : m_pDevice(System::Device()) {}
+Swapchain::Swapchain() : m_pDevice(System::Device()),
+                         m_pTimeline(System::Device()->getGraphicTimeline()) {}
 
 void Swapchain::cleanup() { m_cleaner.flush("Swapchain"); }
 
 void Swapchain::recreate() {
     LOG("Swapchain::recreate");
+    HitchRecorder::mark("swapchain recreate");
     cleanup();
     setup();
     create();
@@ -44,81 +46,144 @@ void Swapchain::setup() {
     m_swapchainInfo = swapchainInfo;
 }
 
+// Headless runs have no surface. The frames are offscreen images of the given
+// size, one per frame in flight, and presenting only moves to the next one.
+void Swapchain::setupHeadless(UInt2D size) {
+    VkSwapchainCreateInfoKHR swapchainInfo{};
+    swapchainInfo.imageExtent = {size.width, size.height};
+    swapchainInfo.imageFormat = m_pDevice->getSurfaceFormat().format;
+    
+    m_swapchainInfo = swapchainInfo;
+    m_headless      = true;
+}
+
 void Swapchain::create() {
     LOG("Swapchain::create");
+    if (m_headless) return;
     VkDevice device = m_pDevice->getDevice();
     VkResult result = vkCreateSwapchainKHR(device, &m_swapchainInfo, nullptr, &m_swapchain);
     CHECK_VKRESULT(result, "failed to create swapchain!");
     m_cleaner.push([=](){ vkDestroySwapchainKHR(device, m_swapchain, nullptr); });
 }
 
+// Frames in flight are a fixed ring of MAX_FRAMES_IN_FLIGHT command buffers,
+// acquire semaphores and timeline values, independent of the swapchain image count.
+// Each frame records from its own transient pool, reset as a whole once the
+// frame's previous submission has completed.
 void Swapchain::createFrames(Renderpass* renderpass) {
     LOG("Swapchain::createFrames");
     VkDevice       device      = m_pDevice->getDevice();
-    Commander*     pCommander  = System::Commander();
     Renderpass*    pRenderpass = renderpass;
     VkSwapchainKHR swapchain   = m_swapchain;
     VkSwapchainCreateInfoKHR swapchainInfo = m_swapchainInfo;
 
-    VECTOR<VkImage> swapchainImages = GetSwapchainImages(swapchain);
-    uint32_t totalFrame = UINT32(swapchainImages.size());
+    VECTOR<VkImage> swapchainImages;
+    if (!m_headless) swapchainImages = GetSwapchainImages(swapchain);
+    uint32_t totalFrame = m_headless ? MAX_FRAMES_IN_FLIGHT : UINT32(swapchainImages.size());
     uint32_t width  = swapchainInfo.imageExtent.width;
     uint32_t height = swapchainInfo.imageExtent.height;
 
-    VECTOR<VkCommandBuffer> commandBuffers = pCommander->createCommandBuffers(totalFrame);
-    VECTOR<VkSemaphore> imageSemaphores(totalFrame);
+    VECTOR<VkCommandPool>   commandPools(MAX_FRAMES_IN_FLIGHT);
+    VECTOR<VkCommandBuffer> commandBuffers(MAX_FRAMES_IN_FLIGHT);
+    VECTOR<VkSemaphore> imageSemaphores(MAX_FRAMES_IN_FLIGHT);
     VECTOR<VkSemaphore> submitSemaphores(totalFrame);
-    VECTOR<VkFence>     fences(totalFrame);
+    VECTOR<uint64_t>    frameValues(MAX_FRAMES_IN_FLIGHT, 0);
+    VECTOR<uint64_t>    imageValues(totalFrame, 0);
     VECTOR<Frame*>      frames(totalFrame);
     
     VkSemaphoreCreateInfo semaphoreInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = m_pDevice->getGraphicQueueIndex();
+    
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
     
     for (size_t i = 0; i < totalFrame; i++) {
         frames[i] = new Frame({width, height});
-        frames[i]->createImageResource(swapchainImages[i], swapchainInfo.imageFormat);
+        if (m_headless) frames[i]->createImageResource();
+        else            frames[i]->createImageResource(swapchainImages[i], swapchainInfo.imageFormat);
         frames[i]->createFramebuffer(pRenderpass);
         
-        vkCreateFence(device, &fenceInfo, nullptr, &fences[i]);
-        vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageSemaphores[i]);
         vkCreateSemaphore(device, &semaphoreInfo, nullptr, &submitSemaphores[i]);
 
         m_cleaner.push([=](){ frames[i]->cleanup(); });
-        m_cleaner.push([=](){ vkDestroyFence(device, fences[i], nullptr); });
-        m_cleaner.push([=](){ vkDestroySemaphore(device, imageSemaphores[i], nullptr); });
         m_cleaner.push([=](){ vkDestroySemaphore(device, submitSemaphores[i], nullptr); });
     }
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageSemaphores[i]);
+        m_cleaner.push([=](){ vkDestroySemaphore(device, imageSemaphores[i], nullptr); });
+        
+        VkResult result = vkCreateCommandPool(device, &poolInfo, nullptr, &commandPools[i]);
+        CHECK_VKRESULT(result, "failed to create frame command pool!");
+        m_cleaner.push([=](){ vkDestroyCommandPool(device, commandPools[i], nullptr); });
+        
+        allocInfo.commandPool = commandPools[i];
+        result = vkAllocateCommandBuffers(device, &allocInfo, &commandBuffers[i]);
+        CHECK_VKRESULT(result, "failed to allocate frame command buffer!");
+    }
     m_cleaner.push([=]() { System::Device()->waitAllQueueIdle(); });
     
     m_frames = frames;
     m_totalFrame = totalFrame;
-    m_submitFences = fences;
+    m_frameValues = frameValues;
     m_submitSemaphores = submitSemaphores;
     m_imageSemaphores = imageSemaphores;
+    m_imageValues = imageValues;
+    m_commandPools = commandPools;
     m_commandBuffers = commandBuffers;
     m_pRenderpass = renderpass;
+    m_frameIdx = 0;
 }
 
 void Swapchain::prepareFrame() {
 //    LOG("Swapchain::prepareFrame");
-    VkDevice device = System::Device()->getDevice();
-    VkResult result = vkAcquireNextImageKHR(device, m_swapchain,
-                                            UINT64_MAX, getImageSemaphore(),
-                                            VK_NULL_HANDLE, &m_frameIdx);
+    TRACE_SCOPE("prepare frame");
+    STALL_SITE("Swapchain::prepareFrame");
+    VkDevice  device    = System::Device()->getDevice();
+    Timeline* pTimeline = m_pTimeline;
+    {
+        TRACE_SCOPE("wait frame");
+        pTimeline->wait(m_frameValues[m_frameIdx]);
+    }
+    vkResetCommandPool(device, m_commandPools[m_frameIdx], 0);
+    
+    if (m_headless) {
+        m_imageIdx = m_frameIdx;
+        return;
+    }
+    
+    VkResult result;
+    {
+        TRACE_SCOPE("acquire image");
+        STALL_SCOPE(Acquire);
+        result = vkAcquireNextImageKHR(device, m_swapchain,
+                                       UINT64_MAX, getImageSemaphore(),
+                                       VK_NULL_HANDLE, &m_imageIdx);
+    }
 
     checkSwapchainResult(result);
     
-    VkFence submitFence = getSubmitFence();
-    vkWaitForFences(device, 1, &submitFence, VK_TRUE, UINT64_MAX);
+    // The acquired image may still be used by an older frame in flight
+    TRACE_SCOPE("wait image");
+    pTimeline->wait(m_imageValues[m_imageIdx]);
 }
 
 void Swapchain::submitFrame() {
+    submitFrame(nullptr, 0, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+}
+
+// Optionally holds the frame at waitStage until another queue's timeline
+// reaches waitValue, e.g. the simulation it renders
+void Swapchain::submitFrame(Timeline* pWaitTimeline, uint64_t waitValue, VkPipelineStageFlags waitStage) {
 //    LOG("Swapchain::submitFrame");
-    VkDevice device = m_pDevice->getDevice();
-    VkQueue graphicQueue = m_pDevice->getGraphicQueue();
-    VkFence submitFence  = getSubmitFence();
+    TRACE_SCOPE("submit frame");
+    STALL_SITE("Swapchain::submitFrame");
+    Timeline* pTimeline = m_pTimeline;
     VkSemaphore imageSemaphore  = getImageSemaphore();
     VkSemaphore submitSemaphore = getSubmitSemaphore();
     VkCommandBuffer cmdBuffer   = getCommandBuffer();
@@ -134,18 +199,28 @@ void Swapchain::submitFrame() {
     submitInfo.commandBufferCount   = 1;
     submitInfo.pCommandBuffers      = &cmdBuffer;
     
-    vkResetFences(device, 1, &submitFence);
-    VkResult result = vkQueueSubmit(graphicQueue, 1, &submitInfo, submitFence);
-    CHECK_VKRESULT(result, "failed to submit draw command buffer!");
+    if (m_headless) {
+        submitInfo.waitSemaphoreCount   = 0;
+        submitInfo.signalSemaphoreCount = 0;
+    }
+    
+    uint64_t value = pTimeline->submit(submitInfo, pWaitTimeline, waitValue, waitStage);
+    m_frameValues[m_frameIdx] = value;
+    m_imageValues[m_imageIdx] = value;
 }
 
 void Swapchain::presentFrame() {
 //    LOG("Swapchain::presentFrame");
+    TRACE_SCOPE("present frame");
+    STALL_SITE("Swapchain::presentFrame");
     VkQueue        presentQueue = m_pDevice->getPresentQueue();
     VkSwapchainKHR swapchain = m_swapchain;
     VkSemaphore    submitSemaphore = getSubmitSemaphore();
-    uint frameIdx = m_frameIdx;
-    uint totalFrame = m_totalFrame;
+    uint imageIdx = m_imageIdx;
+    if (m_headless) {
+        m_frameIdx = (m_frameIdx + 1) % MAX_FRAMES_IN_FLIGHT;
+        return;
+    }
     
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -153,12 +228,17 @@ void Swapchain::presentFrame() {
     presentInfo.pSwapchains        = &swapchain;
     presentInfo.waitSemaphoreCount = 1;
     presentInfo.pWaitSemaphores    = &submitSemaphore;
-    presentInfo.pImageIndices      = &frameIdx;
+    presentInfo.pImageIndices      = &imageIdx;
 
-    VkResult result = vkQueuePresentKHR(presentQueue, &presentInfo);
+    VkResult result;
+    {
+        STALL_SCOPE(Present);
+        std::lock_guard<std::mutex> lock(m_pDevice->getQueueMutex());
+        result = vkQueuePresentKHR(presentQueue, &presentInfo);
+    }
     checkSwapchainResult(result);
     
-    m_semaphoreIdx = (m_semaphoreIdx + 1) % totalFrame;
+    m_frameIdx = (m_frameIdx + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
 void Swapchain::checkSwapchainResult(VkResult result) {
@@ -167,11 +247,13 @@ void Swapchain::checkSwapchainResult(VkResult result) {
     recreate();
 }
 
-Frame* Swapchain::getCurrentFrame() { return m_frames[m_frameIdx]; }
-VkFence Swapchain::getSubmitFence() { return m_submitFences[m_frameIdx]; }
+uint Swapchain::getFrameIdx() { return m_frameIdx; }
+uint64_t Swapchain::getSubmitValue() { return m_frameValues[m_frameIdx]; }
+Timeline* Swapchain::getTimeline() { return m_pTimeline; }
+Frame* Swapchain::getCurrentFrame() { return m_frames[m_imageIdx]; }
 VkCommandBuffer Swapchain::getCommandBuffer() { return m_commandBuffers[m_frameIdx]; }
-VkSemaphore Swapchain::getImageSemaphore()  { return m_imageSemaphores[m_semaphoreIdx]; }
-VkSemaphore Swapchain::getSubmitSemaphore() { return m_submitSemaphores[m_semaphoreIdx]; }
+VkSemaphore Swapchain::getImageSemaphore()  { return m_imageSemaphores[m_frameIdx]; }
+VkSemaphore Swapchain::getSubmitSemaphore() { return m_submitSemaphores[m_imageIdx]; }
 
 
 // Private ==================================================
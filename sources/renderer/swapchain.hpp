@@ -7,6 +7,7 @@
 #include "renderpass.hpp"
 #include "frame.hpp"
 #include "device.hpp"
+#include "timeline.hpp"
 
 class Swapchain {
     
@@ -18,15 +19,19 @@ public:
     void recreate();
     
     void setup();
+    void setupHeadless(UInt2D size);
     void create();
     void createRenderpass();
     void createFrames(Renderpass* renderpass);
     
     void prepareFrame();
     void submitFrame();
+    void submitFrame(Timeline* pWaitTimeline, uint64_t waitValue, VkPipelineStageFlags waitStage);
     void presentFrame();
     
-    VkFence getSubmitFence();
+    uint    getFrameIdx();
+    uint64_t getSubmitValue();
+    Timeline* getTimeline();
     VkCommandBuffer getCommandBuffer();
     VkSemaphore getImageSemaphore();
     VkSemaphore getSubmitSemaphore();
@@ -37,16 +42,23 @@ public:
 private:
     Cleaner m_cleaner;
     Device* m_pDevice;
+    Timeline* m_pTimeline;
     Renderpass* m_pRenderpass;
     
+    bool m_headless   = false;
     uint m_totalFrame = 0;
+    uint m_imageIdx = 0;
     uint m_frameIdx = 0;
-    uint m_semaphoreIdx = 0;
     
+    // Per swapchain image
     VECTOR<Frame*>  m_frames;
-    VECTOR<VkFence> m_submitFences;
+    VECTOR<uint64_t> m_imageValues;
     VECTOR<VkSemaphore> m_submitSemaphores;
+    
+    // Per frame in flight
+    VECTOR<uint64_t> m_frameValues;
     VECTOR<VkSemaphore> m_imageSemaphores;
+    VECTOR<VkCommandPool>   m_commandPools;
     VECTOR<VkCommandBuffer> m_commandBuffers;
     
     VkSwapchainKHR m_swapchain;
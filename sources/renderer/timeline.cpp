@@ -0,0 +1,123 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "timeline.hpp"
+#include "stall_auditor.hpp"
+
+#include <algorithm>
+#include <array>
+
+Timeline::~Timeline() {}
+Timeline::Timeline(Device* pDevice, VkQueue queue) : m_pDevice(pDevice), m_queue(queue) {}
+
+void Timeline::cleanup() { m_cleaner.flush("Timeline"); }
+
+void Timeline::create() {
+    LOG("Timeline::create");
+    VkDevice device = m_pDevice->getDevice();
+    
+    VkSemaphoreTypeCreateInfoKHR typeInfo{};
+    typeInfo.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue  = 0;
+    
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+    
+    VkResult result = vkCreateSemaphore(device, &semaphoreInfo, nullptr, &m_semaphore);
+    CHECK_VKRESULT(result, "failed to create timeline semaphore!");
+    m_cleaner.push([=](){ vkDestroySemaphore(device, m_semaphore, nullptr); });
+    
+    m_pfnWaitSemaphores      = (PFN_vkWaitSemaphoresKHR) vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+    m_pfnGetSemaphoreCounter = (PFN_vkGetSemaphoreCounterValueKHR) vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+    CHECK_NULLPTR(m_pfnWaitSemaphores, "failed to load vkWaitSemaphoresKHR!");
+    CHECK_NULLPTR(m_pfnGetSemaphoreCounter, "failed to load vkGetSemaphoreCounterValueKHR!");
+}
+
+uint64_t Timeline::submit(VkSubmitInfo submitInfo) {
+    return submit(submitInfo, nullptr, 0, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+}
+
+// Appends the timeline signal, and optionally a wait on another timeline, to the
+// submit's own semaphores. The value is taken under the queue lock so values
+// reach the queue in increasing order. The lists live on the stack, a submit
+// carries at most TIMELINE_MAX_SEMAPHORES of each.
+uint64_t Timeline::submit(VkSubmitInfo submitInfo, Timeline* pWaitTimeline, uint64_t waitValue,
+                          VkPipelineStageFlags waitStage) {
+    bool waits = pWaitTimeline && waitValue > 0;
+    if (submitInfo.signalSemaphoreCount + 1 > TIMELINE_MAX_SEMAPHORES ||
+        submitInfo.waitSemaphoreCount + waits > TIMELINE_MAX_SEMAPHORES)
+        RUNTIME_ERROR("too many semaphores in timeline submit!");
+    
+    uint32_t signalCount = submitInfo.signalSemaphoreCount;
+    std::array<VkSemaphore, TIMELINE_MAX_SEMAPHORES> signalSemaphores{};
+    std::array<uint64_t,    TIMELINE_MAX_SEMAPHORES> signalValues{};
+    std::copy_n(submitInfo.pSignalSemaphores, signalCount, signalSemaphores.begin());
+    signalSemaphores[signalCount++] = m_semaphore;
+    
+    uint32_t waitCount = submitInfo.waitSemaphoreCount;
+    std::array<VkSemaphore,          TIMELINE_MAX_SEMAPHORES> waitSemaphores{};
+    std::array<VkPipelineStageFlags, TIMELINE_MAX_SEMAPHORES> waitStages{};
+    std::array<uint64_t,             TIMELINE_MAX_SEMAPHORES> waitValues{};
+    std::copy_n(submitInfo.pWaitSemaphores,   waitCount, waitSemaphores.begin());
+    std::copy_n(submitInfo.pWaitDstStageMask, waitCount, waitStages.begin());
+    if (waits) {
+        waitSemaphores[waitCount] = pWaitTimeline->get();
+        waitStages    [waitCount] = waitStage;
+        waitValues    [waitCount] = waitValue;
+        waitCount++;
+    }
+    
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+    timelineInfo.waitSemaphoreValueCount   = waitCount;
+    timelineInfo.pWaitSemaphoreValues      = waitValues.data();
+    timelineInfo.signalSemaphoreValueCount = signalCount;
+    timelineInfo.pSignalSemaphoreValues    = signalValues.data();
+    
+    submitInfo.pNext                = &timelineInfo;
+    submitInfo.waitSemaphoreCount   = waitCount;
+    submitInfo.pWaitSemaphores      = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask    = waitStages.data();
+    submitInfo.signalSemaphoreCount = signalCount;
+    submitInfo.pSignalSemaphores    = signalSemaphores.data();
+    
+    STALL_SCOPE(Submit);
+    std::lock_guard<std::mutex> lock(m_pDevice->getQueueMutex());
+    uint64_t value = m_lastValue + 1;
+    signalValues[signalCount - 1] = value;
+    VkResult result = vkQueueSubmit(m_queue, 1, &submitInfo, VK_NULL_HANDLE);
+    CHECK_VKRESULT(result, "failed to submit to timeline!");
+    m_lastValue = value;
+    return value;
+}
+
+void Timeline::wait(uint64_t value) {
+    if (value == 0) return;
+    VkDevice device = m_pDevice->getDevice();
+    
+    VkSemaphoreWaitInfoKHR waitInfo{};
+    waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores    = &m_semaphore;
+    waitInfo.pValues        = &value;
+    
+    STALL_SCOPE(Wait);
+    VkResult result = m_pfnWaitSemaphores(device, &waitInfo, UINT64_MAX);
+    CHECK_VKRESULT(result, "failed to wait on timeline!");
+}
+
+void Timeline::waitLast() { wait(m_lastValue); }
+
+bool Timeline::isComplete(uint64_t value) { return getCompletedValue() >= value; }
+
+uint64_t Timeline::getCompletedValue() {
+    uint64_t value = 0;
+    m_pfnGetSemaphoreCounter(m_pDevice->getDevice(), m_semaphore, &value);
+    return value;
+}
+
+uint64_t    Timeline::getLastValue() { return m_lastValue; }
+VkSemaphore Timeline::get()          { return m_semaphore; }
+VkQueue     Timeline::getQueue()     { return m_queue; }
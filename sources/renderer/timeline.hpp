@@ -0,0 +1,47 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "device.hpp"
+
+#include <atomic>
+
+#define TIMELINE_MAX_SEMAPHORES 4
+
+// Timeline semaphore owned by one queue. Every submission through it signals
+// the next value, so the CPU can wait for exactly the work it depends on.
+class Timeline {
+    
+public:
+    ~Timeline();
+    Timeline(Device* pDevice, VkQueue queue);
+    
+    void cleanup();
+    void create();
+    
+    uint64_t submit(VkSubmitInfo submitInfo);
+    uint64_t submit(VkSubmitInfo submitInfo, Timeline* pWaitTimeline, uint64_t waitValue,
+                    VkPipelineStageFlags waitStage);
+    void     wait(uint64_t value);
+    void     waitLast();
+    bool     isComplete(uint64_t value);
+    
+    uint64_t    getCompletedValue();
+    uint64_t    getLastValue();
+    VkSemaphore get();
+    VkQueue     getQueue();
+    
+private:
+    Cleaner m_cleaner;
+    Device* m_pDevice;
+    VkQueue m_queue;
+    
+    VkSemaphore m_semaphore = VK_NULL_HANDLE;
+    std::atomic<uint64_t> m_lastValue{0};
+    
+    PFN_vkWaitSemaphoresKHR           m_pfnWaitSemaphores       = nullptr;
+    PFN_vkGetSemaphoreCounterValueKHR m_pfnGetSemaphoreCounter = nullptr;
+    
+};
@@ -17,8 +17,12 @@ void Buffer::setup(VkDeviceSize size, VkBufferUsageFlags usage) {
     bufferInfo.usage = usage;
     
     m_bufferInfo = bufferInfo;
+    m_memoryTag  = GetDefaultMemoryTag(usage);
 }
 
+// Call after setup, which picks a default from the usage
+void Buffer::setMemoryTag(MemoryTag tag) { m_memoryTag = tag; }
+
 void Buffer::create() {
     createBuffer();
     allocateBufferMemory();
@@ -26,7 +30,7 @@ void Buffer::create() {
 }
 
 void Buffer::createBuffer() {
-    LOG("Buffer::createBuffer");
+    LOGV("Buffer::createBuffer");
     VkDevice device = m_pDevice->getDevice();
     VkResult result = vkCreateBuffer(device, &m_bufferInfo, nullptr, &m_buffer);
     CHECK_VKRESULT(result, "failed to buffer!");
@@ -34,10 +38,11 @@ void Buffer::createBuffer() {
 }
 
 void Buffer::allocateBufferMemory() {
-    LOG("Buffer::allocateBufferMemory");
+    LOGV("Buffer::allocateBufferMemory");
     Device*  pDevice = m_pDevice;
     VkDevice device  = m_pDevice->getDevice();
     VkBuffer buffer  = m_buffer;
+    MemoryTag tag    = m_memoryTag;
     
     VkMemoryRequirements memoryRequirements;
     vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
@@ -52,12 +57,20 @@ void Buffer::allocateBufferMemory() {
     allocInfo.memoryTypeIndex = memoryTypeIndex;
     
     VkDeviceMemory bufferMemory;
-    VkResult       result = vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory);
+    VkResult       result;
+    {
+        STALL_SCOPE(AllocateMemory);
+        result = vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory);
+    }
     CHECK_VKRESULT(result, "failed to allocate buffer memory!");
     vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    pDevice->addMemory(allocInfo.allocationSize, memoryTypeIndex, tag);
     
     m_bufferMemory = bufferMemory;
-    m_cleaner.push([=](){ vkFreeMemory(device, m_bufferMemory, nullptr); });
+    m_cleaner.push([=](){
+        vkFreeMemory(device, m_bufferMemory, nullptr);
+        pDevice->removeMemory(allocInfo.allocationSize, memoryTypeIndex, tag);
+    });
 }
 
 void Buffer::createDescriptorInfo() {
@@ -67,15 +80,28 @@ void Buffer::createDescriptorInfo() {
 }
 
 void Buffer::cmdCopyFromBuffer(VkBuffer sourceBuffer, VkDeviceSize size) {
-    LOG("Buffer::cmdCopyFromBuffer");
-    VkBuffer   buffer    = m_buffer;
-    Commander* pCommander = System::Commander();
+    LOGV("Buffer::cmdCopyFromBuffer");
+    VkBuffer   buffer         = m_buffer;
+    Commander* pCommander     = System::Commander();
+    uint32_t   transferFamily = pCommander->getTransferQueueIndex();
+    uint32_t   graphicFamily  = pCommander->getQueueIndex();
+    
+    VkCommandBuffer transferBuffer = pCommander->createTransferCommandBuffer();
+    pCommander->beginSingleTimeCommands(transferBuffer);
+    VkBufferCopy    copyRegion = { 0, 0, size };
+    vkCmdCopyBuffer(transferBuffer, sourceBuffer, buffer, 1, &copyRegion);
+    cmdTransferOwnership(transferBuffer, transferFamily, graphicFamily,
+                         VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    uint64_t transferValue = pCommander->submitTransferCommands(transferBuffer);
     
+    // The acquire half only exists when the copy ran on another family
     VkCommandBuffer cmdBuffer = pCommander->createCommandBuffer();
     pCommander->beginSingleTimeCommands(cmdBuffer);
-    VkBufferCopy    copyRegion = { 0, 0, size };
-    vkCmdCopyBuffer(cmdBuffer, sourceBuffer, buffer, 1, &copyRegion);
-    pCommander->endSingleTimeCommands(cmdBuffer);
+    cmdTransferOwnership(cmdBuffer, transferFamily, graphicFamily,
+                         0, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    pCommander->endSingleTimeCommands(cmdBuffer, transferValue);
 }
 
 void Buffer::cmdClearBuffer(VkCommandBuffer cmdBuffer, float fdata) {
@@ -84,6 +110,44 @@ void Buffer::cmdClearBuffer(VkCommandBuffer cmdBuffer, float fdata) {
     vkCmdFillBuffer(cmdBuffer, m_buffer, 0, m_bufferInfo.size, fbits);
 }
 
+void Buffer::cmdTransferOwnership(VkCommandBuffer cmdBuffer,
+                                  uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                                  VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                                  VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) {
+    BarrierBatch batch;
+    addOwnershipTransfer(&batch, srcQueueFamily, dstQueueFamily, srcAccess, dstAccess, srcStage, dstStage);
+    batch.flush(cmdBuffer);
+}
+
+void Buffer::addBarrier(BarrierBatch* pBatch,
+                        VkAccessFlags2KHR srcAccess, VkAccessFlags2KHR dstAccess,
+                        VkPipelineStageFlags2KHR srcStage, VkPipelineStageFlags2KHR dstStage) {
+    VkBufferMemoryBarrier2KHR barrier = BarrierBatch::GetDefaultBufferBarrier();
+    barrier.buffer        = m_buffer;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcStageMask  = srcStage;
+    barrier.dstStageMask  = dstStage;
+    pBatch->addBufferBarrier(barrier);
+}
+
+void Buffer::addOwnershipTransfer(BarrierBatch* pBatch,
+                                  uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                                  VkAccessFlags2KHR srcAccess, VkAccessFlags2KHR dstAccess,
+                                  VkPipelineStageFlags2KHR srcStage, VkPipelineStageFlags2KHR dstStage) {
+    if (srcQueueFamily == dstQueueFamily) return;
+    
+    VkBufferMemoryBarrier2KHR barrier = BarrierBatch::GetDefaultBufferBarrier();
+    barrier.buffer        = m_buffer;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcStageMask  = srcStage == VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT_KHR    ? VK_PIPELINE_STAGE_2_NONE_KHR : srcStage;
+    barrier.dstStageMask  = dstStage == VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT_KHR ? VK_PIPELINE_STAGE_2_NONE_KHR : dstStage;
+    barrier.srcQueueFamilyIndex = srcQueueFamily;
+    barrier.dstQueueFamilyIndex = dstQueueFamily;
+    pBatch->addBufferBarrier(barrier);
+}
+
 void* Buffer::fillBuffer(const void* address, VkDeviceSize size, uint32_t shift) {
     void* ptr = mapMemory(size);
     ptr = static_cast<char*>(ptr) + shift;
@@ -124,3 +188,12 @@ VkBufferCreateInfo Buffer::GetDefaultBufferCreateInfo() {
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     return bufferInfo;
 }
+
+// Staging, uniform and geometry buffers are known from their usage, others
+// are tagged by their owner
+MemoryTag Buffer::GetDefaultMemoryTag(VkBufferUsageFlags usage) {
+    if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)  return MEMORY_TAG_STAGING;
+    if (usage &  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) return MEMORY_TAG_FRAME;
+    if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) return MEMORY_TAG_MESH;
+    return MEMORY_TAG_OTHER;
+}
@@ -5,6 +5,7 @@
 
 #include "../include.h"
 #include "device.hpp"
+#include "barrier_batch.hpp"
 
 class Buffer {
     
@@ -15,6 +16,7 @@ public:
     void cleanup();
     
     void setup (VkDeviceSize size, VkBufferUsageFlags usage);
+    void setMemoryTag(MemoryTag tag);
     void create();
     
     void createBuffer();
@@ -23,6 +25,17 @@ public:
     
     void cmdCopyFromBuffer(VkBuffer sourceBuffer, VkDeviceSize size);
     void cmdClearBuffer(VkCommandBuffer cmdBuffer, float fdata);
+    void cmdTransferOwnership(VkCommandBuffer cmdBuffer,
+                              uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                              VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                              VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage);
+    void addBarrier(BarrierBatch* pBatch,
+                    VkAccessFlags2KHR srcAccess, VkAccessFlags2KHR dstAccess,
+                    VkPipelineStageFlags2KHR srcStage, VkPipelineStageFlags2KHR dstStage);
+    void addOwnershipTransfer(BarrierBatch* pBatch,
+                              uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                              VkAccessFlags2KHR srcAccess, VkAccessFlags2KHR dstAccess,
+                              VkPipelineStageFlags2KHR srcStage, VkPipelineStageFlags2KHR dstStage);
     
     void* fillBuffer    (const void* address, VkDeviceSize size, uint32_t shift = 0);
     void* fillBufferFull(const void* address);
@@ -46,7 +59,9 @@ private:
     
     VkBuffer         m_buffer         = VK_NULL_HANDLE;
     VkDeviceMemory   m_bufferMemory   = VK_NULL_HANDLE;
+    MemoryTag        m_memoryTag      = MEMORY_TAG_OTHER;
     VkDescriptorBufferInfo m_descriptorInfo{};
     
     static VkBufferCreateInfo GetDefaultBufferCreateInfo();
+    static MemoryTag GetDefaultMemoryTag(VkBufferUsageFlags usage);
 };
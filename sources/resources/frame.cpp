@@ -19,6 +19,13 @@ void Frame::createDepthResource() {
     m_cleaner.push([=](){ m_attachments.pop_back(); });
 }
 
+// The image is borrowed, its owner cleans it up.
+void Frame::createDepthResource(Image* pDepthImage) {
+    m_pDepthImage = pDepthImage;
+    m_attachments.push_back(m_pDepthImage->getImageView());
+    m_cleaner.push([=](){ m_attachments.pop_back(); });
+}
+
 void Frame::createImageResource() {
     m_pColorImage = new Image();
     m_pColorImage->setupForColor(m_size);
@@ -28,6 +35,13 @@ void Frame::createImageResource() {
     m_cleaner.push([=](){ m_attachments.pop_back(); });
 }
 
+// The image is borrowed, its owner cleans it up.
+void Frame::createImageResource(Image* pColorImage) {
+    m_pColorImage = pColorImage;
+    m_attachments.push_back(m_pColorImage->getImageView());
+    m_cleaner.push([=](){ m_attachments.pop_back(); });
+}
+
 void Frame::createImageResource(VkImage image, VkFormat format) {
     m_pColorImage = new Image();
     m_pColorImage->setupForSwapchain(image, format);
@@ -40,13 +54,21 @@ void Frame::createImageResource(VkImage image, VkFormat format) {
 void Frame::createCubeResource() {
     m_layer = 6;
     m_pColorImage = new Image();
-    m_pColorImage->setupForCubemap(m_size);
+    m_pColorImage->setupForCubeTarget(m_size);
     m_pColorImage->createWithSampler();
     m_attachments.push_back(m_pColorImage->getImageView());
     m_cleaner.push([=](){ m_pColorImage->cleanup(); });
     m_cleaner.push([=](){ m_attachments.pop_back(); });
 }
 
+// The image is borrowed, its owner cleans it up.
+void Frame::createCubeResource(Image* pColorImage) {
+    m_layer = 6;
+    m_pColorImage = pColorImage;
+    m_attachments.push_back(m_pColorImage->getImageView());
+    m_cleaner.push([=](){ m_attachments.pop_back(); });
+}
+
 void Frame::createFramebuffer(Renderpass* renderpass) {
     LOG("createFramebuffer");
     VkDevice device = m_pDevice->getDevice();
@@ -18,9 +18,12 @@ public:
     void cleanup();
     
     void createDepthResource();
+    void createDepthResource(Image* pDepthImage);
     void createImageResource();
+    void createImageResource(Image* pColorImage);
     void createImageResource(VkImage image, VkFormat format);
     void createCubeResource();
+    void createCubeResource(Image* pColorImage);
     void createFramebuffer(Renderpass* renderpass);
     
     VkFramebuffer getFramebuffer();
@@ -6,6 +6,10 @@
 #include "../system.hpp"
 #include "buffer.hpp"
 
+#include <algorithm>
+
+// The one translation unit holding stb_image
+#define STB_IMAGE_IMPLEMENTATION
 #include "../extensions/ext_stb_image.h"
 
 Image::~Image() {}
@@ -17,7 +21,7 @@ Image::Image() : m_pDevice(System::Device()),
 void Image::cleanup() { m_cleaner.flush("Image"); }
 
 void Image::setupForDepth(UInt2D size) {
-    LOG("Image::setupForDepth");
+    LOGV("Image::setupForDepth");
     m_imageInfo.extent = {size.width, size.height, 1};
     m_imageInfo.format = VK_FORMAT_D24_UNORM_S8_UINT;
     m_imageInfo.usage  = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
@@ -26,10 +30,11 @@ void Image::setupForDepth(UInt2D size) {
     
     m_imageViewInfo.format = m_imageInfo.format;
     m_imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    m_memoryTag = MEMORY_TAG_FRAME;
 }
 
 void Image::setupForColor(UInt2D size) {
-    LOG("Image::setupForColor");
+    LOGV("Image::setupForColor");
     m_imageInfo.extent = {size.width, size.height, 1};
     m_imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
     m_imageInfo.usage  = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
@@ -38,6 +43,7 @@ void Image::setupForColor(UInt2D size) {
     
     m_imageViewInfo.format = m_imageInfo.format;
     m_imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    m_memoryTag = MEMORY_TAG_FRAME;
 }
 
 void Image::setupForStorage(UInt2D size) {
@@ -52,14 +58,14 @@ void Image::setupForStorage(UInt2D size) {
 }
 
 void Image::setupForSwapchain(VkImage image, VkFormat imageFormat) {
-    LOG("Image::setupForSwapchain");
+    LOGV("Image::setupForSwapchain");
     m_image = image;
     m_imageInfo.format = imageFormat;
     m_imageViewInfo.format = imageFormat;
 }
 
 void Image::setupForTexture(const std::string filepath) {
-    LOG("Image::setupForTexture");
+    LOGV("Image::setupForTexture");
     int width, height, channels;
     m_rawData = STBI::LoadImage(filepath, &width, &height, &channels);
     m_rawChannel = channels;
@@ -77,10 +83,11 @@ void Image::setupForTexture(UInt2D size) {
     
     m_imageViewInfo.format = m_imageInfo.format;
     m_imageViewInfo.subresourceRange.levelCount = m_imageInfo.mipLevels;
+    m_memoryTag = MEMORY_TAG_TEXTURE;
 }
 
 void Image::setupForHDRTexture(const std::string filepath) {
-    LOG("Image::setupForHDRTexture");
+    LOGV("Image::setupForHDRTexture");
     int width, height, channels;
     m_rawHDR = STBI::LoadHDR(filepath, &width, &height, &channels);
     m_rawChannel = channels;
@@ -91,7 +98,7 @@ void Image::setupForHDRTexture(const std::string filepath) {
 void Image::setupForHDRTexture(UInt2D size) {
     m_imageInfo.extent    = {size.width, size.height, 1};
     m_imageInfo.mipLevels = MaxMipLevel(size.width, size.height);
-    m_imageInfo.format    = VK_FORMAT_R32G32B32A32_SFLOAT;
+    m_imageInfo.format    = m_pDevice->getHDRStorageFormat();
     m_imageInfo.usage     = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
                             VK_IMAGE_USAGE_TRANSFER_DST_BIT |
                             VK_IMAGE_USAGE_STORAGE_BIT |
@@ -99,24 +106,33 @@ void Image::setupForHDRTexture(UInt2D size) {
         
     m_imageViewInfo.format = m_imageInfo.format;
     m_imageViewInfo.subresourceRange.levelCount = m_imageInfo.mipLevels;
+    m_memoryTag = MEMORY_TAG_IBL;
 }
 
 void Image::setupForCubemap(UInt2D size) {
     m_imageInfo.extent       = {size.width, size.height, 1};
     m_imageInfo.mipLevels    = 1;
     m_imageInfo.arrayLayers  = 6;
-    m_imageInfo.format       = VK_FORMAT_R32G32B32A32_SFLOAT;
+    m_imageInfo.format       = m_pDevice->getHDRSampledFormat();
     m_imageInfo.flags        = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-    m_imageInfo.usage        = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
-                               VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+    m_imageInfo.usage        = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
                                VK_IMAGE_USAGE_TRANSFER_DST_BIT |
-                               VK_IMAGE_USAGE_STORAGE_BIT |
                                VK_IMAGE_USAGE_SAMPLED_BIT;
       
     m_imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
     m_imageViewInfo.format   = m_imageInfo.format;
     m_imageViewInfo.subresourceRange.levelCount = 1;
     m_imageViewInfo.subresourceRange.layerCount = 6;
+    m_memoryTag = MEMORY_TAG_IBL;
+}
+
+void Image::setupForCubeTarget(UInt2D size) {
+    setupForCubemap(size);
+    m_imageInfo.format       = m_pDevice->getHDRAttachmentFormat();
+    m_imageInfo.usage        = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                               VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                               VK_IMAGE_USAGE_SAMPLED_BIT;
+    m_imageViewInfo.format   = m_imageInfo.format;
 }
 
 void Image::create() {
@@ -137,7 +153,7 @@ void Image::createForSwapchain() {
 }
 
 void Image::createImage() {
-    LOG("Image::createImage");
+    LOGV("Image::createImage");
     VkDevice device = m_pDevice->getDevice();
     VkResult result = vkCreateImage(device, &m_imageInfo, nullptr, &m_image);
     CHECK_VKRESULT(result, "failed to create image!");
@@ -145,7 +161,7 @@ void Image::createImage() {
 }
 
 void Image::createImageViews() {
-    LOG("Image::createImageViews");
+    LOGV("Image::createImageViews");
     VkDevice device = m_pDevice->getDevice();
     uint mipLevels = m_imageInfo.mipLevels;
     m_imageViews.resize(mipLevels);
@@ -162,10 +178,11 @@ void Image::createImageViews() {
 }
 
 void Image::allocateImageMemory() {
-    LOG("Image::allocateImageMemory");
+    LOGV("Image::allocateImageMemory");
     Device*  pDevice = m_pDevice;
     VkDevice device  = m_pDevice->getDevice();
     VkImage  image   = m_image;
+    MemoryTag tag    = m_memoryTag;
     
     VkMemoryRequirements memoryRequirements;
     vkGetImageMemoryRequirements(device, image, &memoryRequirements);
@@ -177,14 +194,29 @@ void Image::allocateImageMemory() {
     allocInfo.allocationSize  = memoryRequirements.size;
     allocInfo.memoryTypeIndex = memoryTypeIndex;
     
-    VkResult result = vkAllocateMemory(device, &allocInfo, nullptr, &m_imageMemory);
+    VkResult result;
+    {
+        STALL_SCOPE(AllocateMemory);
+        result = vkAllocateMemory(device, &allocInfo, nullptr, &m_imageMemory);
+    }
     CHECK_VKRESULT(result, "failed to allocate image memory!");
-    m_cleaner.push([=](){ vkFreeMemory(device, m_imageMemory, nullptr); });
+    pDevice->addMemory(allocInfo.allocationSize, memoryTypeIndex, tag);
+    m_cleaner.push([=](){
+        vkFreeMemory(device, m_imageMemory, nullptr);
+        pDevice->removeMemory(allocInfo.allocationSize, memoryTypeIndex, tag);
+    });
     vkBindImageMemory(device, image, m_imageMemory, 0);
 }
 
+// Memory is owned by the caller, e.g. a ScratchArena aliasing it with other images.
+void Image::bindImageMemory(VkDeviceMemory memory, VkDeviceSize offset) {
+    VkDevice device = m_pDevice->getDevice();
+    VkResult result = vkBindImageMemory(device, m_image, memory, offset);
+    CHECK_VKRESULT(result, "failed to bind image memory!");
+}
+
 void Image::createSampler() {
-    LOG("Image::createSampler");
+    LOGV("Image::createSampler");
     VkDevice device    = m_pDevice->getDevice();
     float    mipLevels = m_imageInfo.mipLevels;
     
@@ -212,24 +244,39 @@ void Image::createSampler() {
 }
 
 void Image::cmdCopyRawDataToImage() {
-    LOG("Image::copyRawDataToImage");
+    LOGV("Image::copyRawDataToImage");
     Buffer *tempBuffer = new Buffer();
     tempBuffer->setup(getDeviceSize(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
     tempBuffer->create();
     tempBuffer->fillBufferFull(m_rawData);
     
-    Commander* pCommander = System::Commander();
+    // Copy mip 0 on the transfer queue, then hand the image to graphics for
+    // the blits. The acquire waits on the copy's timeline value on the GPU.
+    Commander* pCommander     = System::Commander();
+    uint32_t   transferFamily = pCommander->getTransferQueueIndex();
+    uint32_t   graphicFamily  = pCommander->getQueueIndex();
+    
+    VkCommandBuffer transferBuffer = pCommander->createTransferCommandBuffer();
+    pCommander->beginSingleTimeCommands(transferBuffer);
+    cmdTransitionToTransferDst(transferBuffer);
+    cmdCopyBufferToImage(transferBuffer, tempBuffer->get());
+    cmdTransferOwnership(transferBuffer, transferFamily, graphicFamily,
+                         VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    uint64_t transferValue = pCommander->submitTransferCommands(transferBuffer);
+    
     VkCommandBuffer cmdBuffer = pCommander->createCommandBuffer();
     pCommander->beginSingleTimeCommands(cmdBuffer);
-    cmdTransitionToTransferDst(cmdBuffer);
-    cmdCopyBufferToImage(cmdBuffer, tempBuffer->get());
+    cmdTransferOwnership(cmdBuffer, transferFamily, graphicFamily,
+                         0, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
     cmdGenerateMipmaps(cmdBuffer);
-    pCommander->endSingleTimeCommands(cmdBuffer);
+    pCommander->endSingleTimeCommands(cmdBuffer, transferValue);
     tempBuffer->cleanup();
 }
 
 void Image::cmdClearColorImage(VkClearColorValue clearColor) {
-    LOG("Image::cmdClearColorImage");
+    LOGV("Image::cmdClearColorImage");
     Commander*      pCommander = System::Commander();
     VkCommandBuffer cmdBuffer  = pCommander->createCommandBuffer();
     pCommander->beginSingleTimeCommands(cmdBuffer);
@@ -271,8 +318,39 @@ void Image::cmdCopyImageToImage(VkCommandBuffer cmdBuffer, Image* pSrcImage, VkE
                    1, &region);
 }
 
+void Image::cmdBlitImageToImage(VkCommandBuffer cmdBuffer, Image* pSrcImage, VkExtent3D extent, uint srcMipLevel, uint dstMipLevel) {
+    VkImage               srcImage         = pSrcImage->getImage();
+    VkImageLayout         srcImageLayout   = pSrcImage->getImageLayout();
+    VkImageViewCreateInfo srcImageViewInfo = pSrcImage->getImageViewInfo();
+    VkImage               dstImage         = m_image;
+    VkImageLayout         dstImageLayout   = m_imageLayout;
+    VkImageViewCreateInfo dstImageViewInfo = m_imageViewInfo;
+    
+    VkImageBlit blit{};
+    blit.srcOffsets[0] = { 0, 0, 0 };
+    blit.srcOffsets[1] = { int32_t(extent.width), int32_t(extent.height), 1 };
+    blit.srcSubresource.aspectMask     = srcImageViewInfo.subresourceRange.aspectMask;
+    blit.srcSubresource.baseArrayLayer = srcImageViewInfo.subresourceRange.baseArrayLayer;
+    blit.srcSubresource.layerCount     = srcImageViewInfo.subresourceRange.layerCount;
+    blit.srcSubresource.mipLevel       = srcMipLevel;
+    
+    blit.dstOffsets[0] = { 0, 0, 0 };
+    blit.dstOffsets[1] = { int32_t(extent.width), int32_t(extent.height), 1 };
+    blit.dstSubresource.aspectMask     = dstImageViewInfo.subresourceRange.aspectMask;
+    blit.dstSubresource.baseArrayLayer = dstImageViewInfo.subresourceRange.baseArrayLayer;
+    blit.dstSubresource.layerCount     = dstImageViewInfo.subresourceRange.layerCount;
+    blit.dstSubresource.mipLevel       = dstMipLevel;
+    
+    // Blit instead of copy so the bake target can be converted to the sampled format
+    vkCmdBlitImage(cmdBuffer,
+                   srcImage, srcImageLayout,
+                   dstImage, dstImageLayout,
+                   1, &blit,
+                   VK_FILTER_NEAREST);
+}
+
 void Image::cmdCopyBufferToImage(VkCommandBuffer cmdBuffer, VkBuffer buffer) {
-    LOG("Image::cmdCopyBufferToImage");
+    LOGV("Image::cmdCopyBufferToImage");
     VkImage               image         = m_image;
     VkImageCreateInfo     imageInfo     = m_imageInfo;
     VkImageViewCreateInfo imageViewInfo = m_imageViewInfo;
@@ -297,7 +375,7 @@ void Image::cmdCopyBufferToImage(VkCommandBuffer cmdBuffer, VkBuffer buffer) {
 }
 
 void Image::cmdGenerateMipmaps(VkCommandBuffer cmdBuffer) {
-    LOG("Image::cmdGenerateMipmaps");
+    LOGV("Image::cmdGenerateMipmaps");
     VkPhysicalDevice      physicalDevice = m_pDevice->getPhysicalDevice();;
     VkImage               image          = m_image;
     VkImageCreateInfo     imageInfo      = m_imageInfo;
@@ -311,10 +389,17 @@ void Image::cmdGenerateMipmaps(VkCommandBuffer cmdBuffer) {
         throw std::runtime_error("texture image format does not support linear blitting!");
     }
     
-    VkImageMemoryBarrier barrier = GetDefaultImageMemoryBarrier();
+    VkImageMemoryBarrier2KHR barrier = BarrierBatch::GetDefaultImageBarrier();
     barrier.image = image;
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
     barrier.subresourceRange.layerCount = layerCount;
-
+    
+    // Returning the previous level to transfer dst rides along with the
+    // next level's transition, so each level costs one barrier call
+    BarrierBatch batch;
     int32_t mipWidth  = imageInfo.extent.width;
     int32_t mipHeight = imageInfo.extent.height;
     
@@ -327,12 +412,8 @@ void Image::cmdGenerateMipmaps(VkCommandBuffer cmdBuffer) {
         barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
         barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        vkCmdPipelineBarrier(cmdBuffer,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &barrier);
+        batch.addImageBarrier(barrier);
+        batch.flush(cmdBuffer);
         
         VkImageBlit blit{};
         blit.srcOffsets[0] = { 0, 0, 0 };
@@ -359,16 +440,12 @@ void Image::cmdGenerateMipmaps(VkCommandBuffer cmdBuffer) {
         barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
         barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        vkCmdPipelineBarrier(cmdBuffer,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT,
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &barrier);
+        batch.addImageBarrier(barrier);
         
         mipWidth  = halfMipWidth;
         mipHeight = halfMipHeight;
     }
+    batch.flush(cmdBuffer);
 }
 
 void Image::cmdTransitionToShaderR(VkCommandBuffer cmdBuffer) {
@@ -419,19 +496,61 @@ void Image::cmdChangeLayout(VkCommandBuffer cmdBuffer,
                             VkAccessFlags dstAccess,
                             VkPipelineStageFlags srcStage,
                             VkPipelineStageFlags dstStage) {
-    VkImageMemoryBarrier barrier = GetDefaultImageMemoryBarrier();
+    BarrierBatch batch;
+    addLayoutChange(&batch, newLayout, 0, dstAccess, srcStage, dstStage);
+    batch.flush(cmdBuffer);
+}
+
+// Queue family ownership transfer, recorded once as a release on the source
+// queue and once as an acquire on the destination. Layout is left unchanged.
+void Image::cmdTransferOwnership(VkCommandBuffer cmdBuffer,
+                                 uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                                 VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                                 VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) {
+    BarrierBatch batch;
+    addOwnershipTransfer(&batch, srcQueueFamily, dstQueueFamily, srcAccess, dstAccess, srcStage, dstStage);
+    batch.flush(cmdBuffer);
+}
+
+// Records the transition into the batch and assumes the new layout right away,
+// the batch has to be flushed before the image is used in it. Top and bottom
+// of pipe become NONE, they only mean no stage in synchronization2.
+void Image::addLayoutChange(BarrierBatch* pBatch,
+                            VkImageLayout newLayout,
+                            VkAccessFlags2KHR srcAccess, VkAccessFlags2KHR dstAccess,
+                            VkPipelineStageFlags2KHR srcStage, VkPipelineStageFlags2KHR dstStage,
+                            bool discard) {
+    VkImageMemoryBarrier2KHR barrier = BarrierBatch::GetDefaultImageBarrier();
     barrier.image         = m_image;
-    barrier.oldLayout     = m_imageLayout;
+    barrier.oldLayout     = discard ? VK_IMAGE_LAYOUT_UNDEFINED : m_imageLayout;
     barrier.newLayout     = newLayout;
+    barrier.srcAccessMask = srcAccess;
     barrier.dstAccessMask = dstAccess;
+    barrier.srcStageMask  = srcStage == VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT_KHR    ? VK_PIPELINE_STAGE_2_NONE_KHR : srcStage;
+    barrier.dstStageMask  = dstStage == VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT_KHR ? VK_PIPELINE_STAGE_2_NONE_KHR : dstStage;
     barrier.subresourceRange = m_imageViewInfo.subresourceRange;
-    
+    pBatch->addImageBarrier(barrier);
     m_imageLayout = newLayout;
-    vkCmdPipelineBarrier(cmdBuffer,
-                         srcStage, dstStage, 0,
-                         0, nullptr,
-                         0, nullptr,
-                         1, &barrier);
+}
+
+void Image::addOwnershipTransfer(BarrierBatch* pBatch,
+                                 uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                                 VkAccessFlags2KHR srcAccess, VkAccessFlags2KHR dstAccess,
+                                 VkPipelineStageFlags2KHR srcStage, VkPipelineStageFlags2KHR dstStage) {
+    if (srcQueueFamily == dstQueueFamily) return;
+    
+    VkImageMemoryBarrier2KHR barrier = BarrierBatch::GetDefaultImageBarrier();
+    barrier.image         = m_image;
+    barrier.oldLayout     = m_imageLayout;
+    barrier.newLayout     = m_imageLayout;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcStageMask  = srcStage == VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT_KHR    ? VK_PIPELINE_STAGE_2_NONE_KHR : srcStage;
+    barrier.dstStageMask  = dstStage == VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT_KHR ? VK_PIPELINE_STAGE_2_NONE_KHR : dstStage;
+    barrier.srcQueueFamilyIndex = srcQueueFamily;
+    barrier.dstQueueFamilyIndex = dstQueueFamily;
+    barrier.subresourceRange    = m_imageViewInfo.subresourceRange;
+    pBatch->addImageBarrier(barrier);
 }
 
 void Image::cmdTransitionToShaderR    () { cmdCall(&Image::cmdTransitionToShaderR);     }
@@ -462,6 +581,12 @@ uint            Image::getMipLevels  () { return m_imageInfo.mipLevels; }
 UInt2D          Image::getImageSize  () { return {m_imageInfo.extent.width, m_imageInfo.extent.height}; }
 VkDeviceSize    Image::getDeviceSize () { return m_imageInfo.extent.width * m_imageInfo.extent.height * getChannelSize() * m_imageInfo.arrayLayers; }
 
+VkMemoryRequirements Image::getMemoryRequirements() {
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(m_pDevice->getDevice(), m_image, &memoryRequirements);
+    return memoryRequirements;
+}
+
 VkImageLayout         Image::getImageLayout()   { return m_imageLayout; }
 VkImageCreateInfo     Image::getImageInfo()     { return m_imageInfo; }
 VkImageViewCreateInfo Image::getImageViewInfo() { return m_imageViewInfo; }
@@ -476,10 +601,28 @@ void Image::setImageFormat(VkFormat format) {
     m_imageViewInfo.format = format;
 }
 
+// Call after setup, which picks a default from the kind of image
+void Image::setMemoryTag(MemoryTag tag) { m_memoryTag = tag; }
+
+// Images touched by more than one queue family skip ownership transfers
+// by being concurrent. Call before createImage.
+void Image::setSharedQueues(VECTOR<uint32_t> queueFamilyIndices) {
+    std::sort(queueFamilyIndices.begin(), queueFamilyIndices.end());
+    queueFamilyIndices.erase(std::unique(queueFamilyIndices.begin(), queueFamilyIndices.end()),
+                             queueFamilyIndices.end());
+    if (queueFamilyIndices.size() < 2) return;
+    
+    m_queueFamilyIndices = queueFamilyIndices;
+    m_imageInfo.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+    m_imageInfo.queueFamilyIndexCount = UINT32(m_queueFamilyIndices.size());
+    m_imageInfo.pQueueFamilyIndices   = m_queueFamilyIndices.data();
+}
+
 
 // Private ==================================================
 
 void Image::cmdCall(void (Image::*cmdFunc)(VkCommandBuffer)) {
+    STALL_SITE("Image::cmdCall");
     Commander*      pCommander = System::Commander();
     VkCommandBuffer cmdBuffer  = pCommander->createCommandBuffer();
     pCommander->beginSingleTimeCommands(cmdBuffer);
@@ -497,6 +640,9 @@ unsigned int Image::GetChannelSize(VkFormat format) {
         case VK_FORMAT_R8G8B8A8_SRGB: return 4; break;
         case VK_FORMAT_R32G32B32_SFLOAT: return 12; break;
         case VK_FORMAT_R32G32B32A32_SFLOAT: return 16; break;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return 8; break;
+        case VK_FORMAT_B10G11R11_UFLOAT_PACK32: return 4; break;
+        case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 : return 4; break;
         default: return 0; break;
     }
 }
@@ -530,18 +676,3 @@ VkImageViewCreateInfo Image::GetDefaultImageViewCreateInfo() {
     imageViewInfo.subresourceRange.layerCount     = 1;
     return imageViewInfo;
 }
-
-VkImageMemoryBarrier Image::GetDefaultImageMemoryBarrier() {
-    VkImageMemoryBarrier barrier{};
-    barrier.sType     = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel   = 0;
-    barrier.subresourceRange.levelCount     = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount     = 1;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = 0;
-    return barrier;
-}
@@ -5,6 +5,7 @@
 
 #include "../include.h"
 #include "device.hpp"
+#include "barrier_batch.hpp"
 
 class Image {
     
@@ -24,6 +25,7 @@ public:
     void setupForHDRTexture (const std::string filepath);
     void setupForHDRTexture (UInt2D size);
     void setupForCubemap    (UInt2D size);
+    void setupForCubeTarget (UInt2D size);
     
     void create             ();
     void createWithSampler  ();
@@ -32,6 +34,7 @@ public:
     void createImage        ();
     void createImageViews   ();
     void allocateImageMemory();
+    void bindImageMemory    (VkDeviceMemory memory, VkDeviceSize offset);
     void createSampler      ();
     
     void cmdCopyRawDataToImage();
@@ -55,9 +58,24 @@ public:
                          VkAccessFlags dstAccess,
                          VkPipelineStageFlags srcStage,
                          VkPipelineStageFlags dstStage);
+    void cmdTransferOwnership(VkCommandBuffer cmdBuffer,
+                              uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                              VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                              VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage);
+    
+    void addLayoutChange(BarrierBatch* pBatch,
+                         VkImageLayout newLayout,
+                         VkAccessFlags2KHR srcAccess, VkAccessFlags2KHR dstAccess,
+                         VkPipelineStageFlags2KHR srcStage, VkPipelineStageFlags2KHR dstStage,
+                         bool discard = false);
+    void addOwnershipTransfer(BarrierBatch* pBatch,
+                              uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                              VkAccessFlags2KHR srcAccess, VkAccessFlags2KHR dstAccess,
+                              VkPipelineStageFlags2KHR srcStage, VkPipelineStageFlags2KHR dstStage);
     
     void cmdCopyImageToImage (VkCommandBuffer cmdBuffer, Image* pSrcImage, VkExtent3D extent, uint srcMipLevel = 0, uint dstMipLevel = 0);
     void cmdCopyImageToImage (VkCommandBuffer cmdBuffer, Image* pSrcImage);
+    void cmdBlitImageToImage (VkCommandBuffer cmdBuffer, Image* pSrcImage, VkExtent3D extent, uint srcMipLevel = 0, uint dstMipLevel = 0);
     void cmdCopyBufferToImage(VkCommandBuffer cmdBuffer, VkBuffer buffer);
     void cmdGenerateMipmaps  (VkCommandBuffer cmdBuffer);
     
@@ -66,6 +84,7 @@ public:
     VkDeviceMemory   getImageMemory();
     UInt2D           getImageSize  ();
     VkDeviceSize     getDeviceSize ();
+    VkMemoryRequirements getMemoryRequirements();
     VkSampler        getSampler    ();
     uint             getRawChannel ();
     uint             getChannelSize();
@@ -82,6 +101,8 @@ public:
     void setMipLevels(uint mipLevels);
     void setImageLayout(VkImageLayout imageLayout);
     void setImageFormat(VkFormat format);
+    void setSharedQueues(VECTOR<uint32_t> queueFamilyIndices);
+    void setMemoryTag(MemoryTag tag);
     
 private:
     Cleaner m_cleaner;
@@ -93,12 +114,14 @@ private:
 
     VkImage          m_image          = VK_NULL_HANDLE;
     VkDeviceMemory   m_imageMemory    = VK_NULL_HANDLE;
+    MemoryTag        m_memoryTag      = MEMORY_TAG_OTHER;
     VECTOR<VkImageView> m_imageViews;
     
     VkImageLayout         m_imageLayout;
     VkImageCreateInfo     m_imageInfo{};
     VkImageViewCreateInfo m_imageViewInfo{};
     VECTOR<VkDescriptorImageInfo> m_descriptorInfos;
+    VECTOR<uint32_t>      m_queueFamilyIndices;
 
     // For Texture
     VkSampler m_sampler = VK_NULL_HANDLE;
@@ -107,7 +130,6 @@ private:
     static unsigned int GetChannelSize(VkFormat format);
     static VkImageCreateInfo     GetDefaultImageCreateInfo();
     static VkImageViewCreateInfo GetDefaultImageViewCreateInfo();
-    static VkImageMemoryBarrier  GetDefaultImageMemoryBarrier();
     
     void cmdCall(void (Image::*cmdFunc)(VkCommandBuffer));
     
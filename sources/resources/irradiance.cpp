@@ -0,0 +1,102 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "irradiance.hpp"
+
+#include <thread>
+#include <algorithm>
+
+// Basis constants and the cosine lobe convolution (Ramamoorthi & Hanrahan)
+// divided by PI. ProjectRows and the shader both evaluate only the polynomial
+// in N, so each coefficient takes the basis constant twice: once for the
+// projection and once for the reconstruction.
+const float SH_BASIS[SH_COEFFICIENTS] = {
+    0.282095f, 0.488603f, 0.488603f, 0.488603f,
+    1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f
+};
+const float SH_BAND[SH_COEFFICIENTS] = {
+    1.f,
+    2.f / 3.f, 2.f / 3.f, 2.f / 3.f,
+    1.f / 4.f, 1.f / 4.f, 1.f / 4.f, 1.f / 4.f, 1.f / 4.f
+};
+
+Irradiance::~Irradiance() {}
+Irradiance::Irradiance() {}
+
+void Irradiance::projectEquirect(Image* pHDRImage) {
+    projectEquirect(pHDRImage->getRawHDR(), pHDRImage->getImageSize(), pHDRImage->getRawChannel());
+}
+
+void Irradiance::projectEquirect(const float* rawHDR, UInt2D size, uint channel) {
+    LOG("Irradiance::projectEquirect");
+    uint width  = size.width;
+    uint height = size.height;
+    
+    VECTOR<float> cosPhi(width), sinPhi(width);
+    for (uint x = 0; x < width; x++) {
+        float phi = ((x + .5f) / width - .5f) * 2.f * PI;
+        cosPhi[x] = cos(phi);
+        sinPhi[x] = sin(phi);
+    }
+    
+    uint totalThread = std::max(1u, std::min(std::thread::hardware_concurrency(), height));
+    uint rowPerThread = (height + totalThread - 1) / totalThread;
+    VECTOR<double> sums(totalThread * SH_COEFFICIENTS * 3, 0.);
+    VECTOR<std::thread> threads;
+    for (uint i = 0; i < totalThread; i++) {
+        uint rowBegin = i * rowPerThread;
+        uint rowEnd   = std::min(rowBegin + rowPerThread, height);
+        threads.push_back(std::thread(ProjectRows, rawHDR, size, channel,
+                                      cosPhi.data(), sinPhi.data(),
+                                      rowBegin, rowEnd, &sums[i * SH_COEFFICIENTS * 3]));
+    }
+    for (std::thread& thread : threads) thread.join();
+    
+    for (uint c = 0; c < SH_COEFFICIENTS; c++) {
+        glm::dvec3 sum(0.);
+        for (uint i = 0; i < totalThread; i++) {
+            double* threadSum = &sums[(i * SH_COEFFICIENTS + c) * 3];
+            sum += glm::dvec3(threadSum[0], threadSum[1], threadSum[2]);
+        }
+        m_coefficients[c] = glm::vec4(glm::vec3(sum) * SH_BASIS[c] * SH_BASIS[c] * SH_BAND[c], 0.f);
+    }
+}
+
+glm::vec4* Irradiance::getCoefficients() { return m_coefficients; }
+
+
+// Private ==================================================
+
+void Irradiance::ProjectRows(const float* rawHDR, UInt2D size, uint channel,
+                             const float* cosPhi, const float* sinPhi,
+                             uint rowBegin, uint rowEnd, double* sums) {
+    uint  width = size.width;
+    float texelArea = (2.f * PI / width) * (PI / size.height);
+    VECTOR<float> rowSum(SH_COEFFICIENTS * 3);
+    
+    for (uint y = rowBegin; y < rowEnd; y++) {
+        float theta    = (y + .5f) / size.height * PI;
+        float sinTheta = sin(theta);
+        float dirY     = cos(theta);
+        float weight   = texelArea * sinTheta;
+        const float* row = rawHDR + (size_t)y * width * channel;
+        std::fill(rowSum.begin(), rowSum.end(), 0.f);
+        
+        for (uint x = 0; x < width; x++) {
+            float dirX = cosPhi[x] * sinTheta;
+            float dirZ = sinPhi[x] * sinTheta;
+            float basis[SH_COEFFICIENTS] = {
+                1.f,
+                dirY, dirZ, dirX,
+                dirX * dirY, dirY * dirZ, 3.f * dirZ * dirZ - 1.f, dirX * dirZ, dirX * dirX - dirY * dirY
+            };
+            const float* texel = row + x * channel;
+            for (uint c = 0; c < SH_COEFFICIENTS; c++) {
+                rowSum[c * 3 + 0] += texel[0] * basis[c];
+                rowSum[c * 3 + 1] += texel[1] * basis[c];
+                rowSum[c * 3 + 2] += texel[2] * basis[c];
+            }
+        }
+        for (uint i = 0; i < SH_COEFFICIENTS * 3; i++) sums[i] += rowSum[i] * weight;
+    }
+}
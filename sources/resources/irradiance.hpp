@@ -0,0 +1,29 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "image.hpp"
+
+#define SH_COEFFICIENTS 9
+
+class Irradiance {
+    
+public:
+    ~Irradiance();
+    Irradiance();
+    
+    void projectEquirect(Image* pHDRImage);
+    void projectEquirect(const float* rawHDR, UInt2D size, uint channel);
+    
+    glm::vec4* getCoefficients();
+    
+private:
+    glm::vec4 m_coefficients[SH_COEFFICIENTS];
+    
+    static void ProjectRows(const float* rawHDR, UInt2D size, uint channel,
+                            const float* cosPhi, const float* sinPhi,
+                            uint rowBegin, uint rowEnd, double* sums);
+    
+};
@@ -167,19 +167,12 @@ void Mesh::createVertexBuffer() {
     LOG("Mesh::createVertexBuffer");
     VkDeviceSize bufferSize = sizeofPositions() + sizeofNormals() + sizeofTexCoords();
     
+    VECTOR<float> vertices = packVertices();
+    
     Buffer* tempBuffer = new Buffer();
     tempBuffer->setup(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
     tempBuffer->create();
-    
-    uint32_t shift = 0;
-    for (int i = 0; i < m_positions.size(); i++) {
-        tempBuffer->fillBuffer(&m_positions[i], m_sizeofPosition, shift);
-        shift += m_sizeofPosition;
-        tempBuffer->fillBuffer(&m_normals  [i], m_sizeofNormal  , shift);
-        shift += m_sizeofNormal;
-        tempBuffer->fillBuffer(&m_texCoords[i], m_sizeofTexCoord, shift);
-        shift += m_sizeofTexCoord;
-    }
+    tempBuffer->fillBufferFull(vertices.data());
     
     Buffer* vertexBuffer = new Buffer();
     vertexBuffer->setup(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
@@ -191,6 +184,22 @@ void Mesh::createVertexBuffer() {
     m_pVertexBuffer = vertexBuffer;
 }
 
+// Interleaved position, normal and texcoord, the layout of the vertex buffer
+VECTOR<float> Mesh::packVertices() {
+    uint32_t stride = (m_sizeofPosition + m_sizeofNormal + m_sizeofTexCoord) / sizeof(float);
+    VECTOR<float> vertices(m_positions.size() * stride);
+    float* pDst = vertices.data();
+    for (size_t i = 0; i < m_positions.size(); i++) {
+        memcpy(pDst, &m_positions[i], m_sizeofPosition);
+        pDst += m_sizeofPosition / sizeof(float);
+        memcpy(pDst, &m_normals  [i], m_sizeofNormal);
+        pDst += m_sizeofNormal   / sizeof(float);
+        memcpy(pDst, &m_texCoords[i], m_sizeofTexCoord);
+        pDst += m_sizeofTexCoord / sizeof(float);
+    }
+    return vertices;
+}
+
 void Mesh::createIndexBuffer() {
     LOG("Mesh::createIndexBuffer");
     VkDeviceSize bufferSize = sizeofIndices();
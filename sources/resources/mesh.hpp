@@ -28,6 +28,8 @@ public:
     void createVertexBuffer();
     void createVertexStateInfo();
     
+    VECTOR<float> packVertices();
+    
     uint32_t sizeofPositions();
     uint32_t sizeofNormals();
     uint32_t sizeofTexCoords();
@@ -0,0 +1,139 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "scratch_arena.hpp"
+
+#include "../system.hpp"
+
+#include <algorithm>
+
+ScratchArena::~ScratchArena() {}
+ScratchArena::ScratchArena() : m_pDevice(System::Device()) {}
+
+void ScratchArena::cleanup() {
+    release();
+    freeMemory();
+    m_cleaner.flush("ScratchArena");
+}
+
+// Call before create(), the block is accounted under the tag
+void ScratchArena::setMemoryTag(MemoryTag tag) { m_memoryTag = tag; }
+
+// The image only needs to be set up, it is created here and gets its memory,
+// views and sampler in create().
+void ScratchArena::addImage(Image* pImage, uint firstStage, uint lastStage) {
+    pImage->createImage();
+    Placement placement{};
+    placement.pImage       = pImage;
+    placement.firstStage   = firstStage;
+    placement.lastStage    = lastStage;
+    placement.requirements = pImage->getMemoryRequirements();
+    m_placements.push_back(placement);
+}
+
+void ScratchArena::create() {
+    LOG("ScratchArena::create");
+    uint32_t typeFilter = UINT32_MAX;
+    for (Placement& placement : m_placements)
+        typeFilter &= placement.requirements.memoryTypeBits;
+    uint32_t memoryTypeIndex = m_pDevice->findMemoryTypeIndex(typeFilter, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    
+    VkDeviceSize size = place();
+    if (size > m_size || memoryTypeIndex != m_memoryTypeIndex)
+        allocateMemory(size, memoryTypeIndex);
+    
+    for (Placement& placement : m_placements) {
+        placement.pImage->bindImageMemory(m_memory, placement.offset);
+        placement.pImage->createImageViews();
+        placement.pImage->createSampler();
+    }
+    LOGV("ScratchArena " << getRequestedSize() << " bytes placed in " << size);
+}
+
+// Destroys every image added since the last release, the memory block is kept
+// for the next round.
+void ScratchArena::release() {
+    for (Placement& placement : m_placements)
+        placement.pImage->cleanup();
+    m_placements.clear();
+}
+
+VkDeviceSize ScratchArena::getSize() { return m_size; }
+
+VkDeviceSize ScratchArena::getRequestedSize() {
+    VkDeviceSize size = 0;
+    for (Placement& placement : m_placements)
+        size += placement.requirements.size;
+    return size;
+}
+
+// Private ==================================================
+
+// First fit, largest image first: each image is pushed past every already
+// placed image that is alive in one of its stages and overlaps its range.
+VkDeviceSize ScratchArena::place() {
+    VECTOR<Placement*> order;
+    for (Placement& placement : m_placements) order.push_back(&placement);
+    std::stable_sort(order.begin(), order.end(), [](Placement* a, Placement* b) {
+        return a->requirements.size > b->requirements.size;
+    });
+    
+    VkDeviceSize size = 0;
+    for (uint i = 0; i < order.size(); i++) {
+        Placement* current = order[i];
+        VkDeviceSize offset = 0;
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (uint j = 0; j < i; j++) {
+                Placement* placed = order[j];
+                VkDeviceSize placedEnd = placed->offset + placed->requirements.size;
+                if (!Overlap(*current, *placed)) continue;
+                if (offset >= placedEnd || placed->offset >= offset + current->requirements.size) continue;
+                offset = AlignUp(placedEnd, current->requirements.alignment);
+                moved  = true;
+            }
+        }
+        current->offset = offset;
+        size = std::max(size, offset + current->requirements.size);
+    }
+    return size;
+}
+
+void ScratchArena::allocateMemory(VkDeviceSize size, uint32_t memoryTypeIndex) {
+    LOG("ScratchArena::allocateMemory");
+    VkDevice device = m_pDevice->getDevice();
+    freeMemory();
+    
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize  = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    
+    VkResult result;
+    {
+        STALL_SCOPE(AllocateMemory);
+        result = vkAllocateMemory(device, &allocInfo, nullptr, &m_memory);
+    }
+    CHECK_VKRESULT(result, "failed to allocate scratch arena memory!");
+    m_pDevice->addMemory(size, memoryTypeIndex, m_memoryTag);
+    m_size = size;
+    m_memoryTypeIndex = memoryTypeIndex;
+}
+
+void ScratchArena::freeMemory() {
+    if (m_memory == VK_NULL_HANDLE) return;
+    VkDevice device = m_pDevice->getDevice();
+    vkFreeMemory(device, m_memory, nullptr);
+    m_pDevice->removeMemory(m_size, m_memoryTypeIndex, m_memoryTag);
+    m_memory = VK_NULL_HANDLE;
+    m_size   = 0;
+}
+
+bool ScratchArena::Overlap(const Placement& a, const Placement& b) {
+    return a.firstStage <= b.lastStage && b.firstStage <= a.lastStage;
+}
+
+VkDeviceSize ScratchArena::AlignUp(VkDeviceSize offset, VkDeviceSize alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
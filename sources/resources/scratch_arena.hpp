@@ -0,0 +1,54 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "../include.h"
+#include "device.hpp"
+#include "image.hpp"
+
+// One device local block shared by transient images. Each image declares the
+// first and last stage it is used in; images whose stages do not overlap are
+// placed over the same memory, so the block only grows to the largest working set.
+class ScratchArena {
+    
+    struct Placement {
+        Image* pImage;
+        uint   firstStage;
+        uint   lastStage;
+        VkMemoryRequirements requirements;
+        VkDeviceSize         offset;
+    };
+    
+public:
+    ~ScratchArena();
+    ScratchArena();
+    
+    void cleanup();
+    
+    void setMemoryTag(MemoryTag tag);
+    void addImage(Image* pImage, uint firstStage, uint lastStage);
+    void create();
+    void release();
+    
+    VkDeviceSize getSize();
+    VkDeviceSize getRequestedSize();
+    
+private:
+    Cleaner m_cleaner;
+    Device* m_pDevice;
+    
+    VkDeviceMemory m_memory = VK_NULL_HANDLE;
+    VkDeviceSize   m_size   = 0;
+    uint32_t       m_memoryTypeIndex = UINT32_MAX;
+    MemoryTag      m_memoryTag       = MEMORY_TAG_OTHER;
+    VECTOR<Placement> m_placements;
+    
+    VkDeviceSize place();
+    void allocateMemory(VkDeviceSize size, uint32_t memoryTypeIndex);
+    void freeMemory();
+    
+    static bool Overlap(const Placement& a, const Placement& b);
+    static VkDeviceSize AlignUp(VkDeviceSize offset, VkDeviceSize alignment);
+    
+};
@@ -25,13 +25,12 @@ public:
     VkShaderModuleCreateInfo        m_shaderInfo{};
     VkPipelineShaderStageCreateInfo m_shaderStageInfo{};
     
+    static std::vector<char> ReadBinaryFile(const std::string filename);
+    
 private:
     Cleaner m_cleaner;
     Device* m_pDevice;
     
     VkShaderModule m_shaderModule = VK_NULL_HANDLE;
     
-    
-    std::vector<char> ReadBinaryFile(const std::string filename);
-    
 };
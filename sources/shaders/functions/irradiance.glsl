@@ -0,0 +1,13 @@
+
+vec4 irradianceSH(vec3 N) {
+    vec3 color = environmentSH.coefficients[0].rgb
+               + environmentSH.coefficients[1].rgb * N.y
+               + environmentSH.coefficients[2].rgb * N.z
+               + environmentSH.coefficients[3].rgb * N.x
+               + environmentSH.coefficients[4].rgb * (N.x * N.y)
+               + environmentSH.coefficients[5].rgb * (N.y * N.z)
+               + environmentSH.coefficients[6].rgb * (3.0 * N.z * N.z - 1.0)
+               + environmentSH.coefficients[7].rgb * (N.x * N.z)
+               + environmentSH.coefficients[8].rgb * (N.x * N.x - N.y * N.y);
+    return vec4(max(color, vec3(0.0)), 1.0);
+}
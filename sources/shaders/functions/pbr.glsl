@@ -85,7 +85,7 @@ vec4 pbr() {
     
     vec4 kS = F;
     vec4 kD = (1.0 - kS) * (1.0 - metallic);
-    vec4 irradiance = texture(envMap, N);
+    vec4 irradiance = irradianceSH(N);
     vec4 diffuse = irradiance * albedo;
     
     const float MAX_REFLECTION_LOD = 4.0;
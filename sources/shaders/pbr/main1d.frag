@@ -46,7 +46,7 @@ layout(set = 3, binding = 0) uniform sampler2D heightMap;
 layout(set = 4, binding = 0) uniform sampler2D interferenceImage;
 layout(set = 4, binding = 1) buffer  markBuffer { float markAlpha[]; };
 layout(set = 5, binding = 0) uniform samplerCube cubemap;
-layout(set = 5, binding = 1) uniform samplerCube envMap;
+layout(set = 5, binding = 1) uniform EnvironmentSH { vec4 coefficients[9]; } environmentSH;
 layout(set = 5, binding = 2) uniform samplerCube reflMap;
 layout(set = 5, binding = 3) uniform sampler2D brdfMap;
 
@@ -61,6 +61,7 @@ layout(location = 0) out vec4 outColor;
 // Functions ==================================================
 #include "../functions/interference.glsl"
 #include "../functions/render_function.glsl"
+#include "../functions/irradiance.glsl"
 #include "../functions/pbr.glsl"
 
 void main() {
@@ -133,7 +134,7 @@ void main() {
     vec4 kD = (1.0 - kS) * (1.0 - metallic);
     kD.a = F.a;
     
-    vec4 irradiance = texture(envMap, N);
+    vec4 irradiance = irradianceSH(N);
     vec4 diffuse = irradiance * albedo;
     
     const float MAX_REFLECTION_LOD = 4.0;
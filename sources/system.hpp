@@ -6,12 +6,19 @@
 #include "files.hpp"
 #include "device.hpp"
 #include "commander.hpp"
+#include "deletion_queue.hpp"
+#include "tracer.hpp"
+#include "alloc_tracker.hpp"
+#include "stall_auditor.hpp"
+#include "hitch_recorder.hpp"
 
 struct Settings {
     bool ShowDemo  = false;
     bool LockFPS   = false;
     bool LockFocus = true;
     
+    float HitchThreshold = HITCH_THRESHOLD_MS; // Frame ms dumped by the hitch recorder, 0 disables
+    
     long Iteration = 0;
     
     glm::vec3 CameraPos = {};
@@ -58,6 +65,9 @@ struct Settings {
     // Button
     bool BtnUpdateTexture = false;
     bool BtnUpdateCubemap = false;
+    bool BtnExportTrace   = false;
+    bool BtnStallReport   = false;
+    bool BtnExportMemory  = false;
     
 };
 
@@ -88,12 +98,14 @@ public:
     Files*      m_pFiles      = nullptr;
     Device*     m_pDevice     = nullptr;
     Commander*  m_pCommander  = nullptr;
+    DeletionQueue* m_pDeletionQueue = nullptr;
     Settings*   m_pSettings   = new struct Settings();
     RenderTime* m_pRenderTime = new struct RenderTime();
     
     static Files*      Files     () { return Instance().m_pFiles;     }
     static Device*     Device    () { return Instance().m_pDevice;     }
-    static Commander*  Commander () { return Instance().m_pCommander;  }
+    static Commander*  Commander () { return ThreadCommander() ? ThreadCommander() : Instance().m_pCommander; }
+    static DeletionQueue* DeletionQueue() { return Instance().m_pDeletionQueue; }
     static Settings*   Settings  () { return Instance().m_pSettings;   }
     static RenderTime* RenderTime() { return Instance().m_pRenderTime; }
     
@@ -101,6 +113,13 @@ public:
     
     static void setDevice   (class Device*    device   ) { Instance().m_pDevice    = device; }
     static void setCommander(class Commander* commander) { Instance().m_pCommander = commander; }
+    static void setDeletionQueue(class DeletionQueue* queue) { Instance().m_pDeletionQueue = queue; }
+    static void setThreadCommander(class Commander* commander) { ThreadCommander() = commander; }
+    
+    static class Commander*& ThreadCommander() {
+        static thread_local class Commander* commander = nullptr; // Overrides the main commander on worker threads
+        return commander;
+    }
     
     static System& Instance() {
         static System instance; // Guaranteed to be destroyed. Instantiated on first use.
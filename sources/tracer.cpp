@@ -0,0 +1,133 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#include "tracer.hpp"
+
+#include <fstream>
+#include <iomanip>
+
+void Tracer::setThreadName(STRING name) {
+    Ring* pRing = ThreadRing();
+    std::lock_guard<std::mutex> lock(RingsMutex());
+    pRing->threadName = name;
+}
+
+// The slot is filled before the head moves past it, so an exporting thread
+// never sees an event that is still being written
+void Tracer::record(const char* name, TimeVal start, TimeVal end) {
+    Ring*    pRing = ThreadRing();
+    uint64_t head  = pRing->head.load(std::memory_order_relaxed);
+    Event&   event = pRing->events[head % TRACE_RING_SIZE];
+    event.name     = name;
+    event.start    = toTraceTime(start);
+    event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    pRing->head.store(head + 1, std::memory_order_release);
+}
+
+bool Tracer::exportChromeTrace(STRING path) {
+    LOG("Tracer::exportChromeTrace");
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        ERR("failed to open trace file " + path);
+        return false;
+    }
+    
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    file << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Sandbox\"}}";
+    writeChromeEvents(file, 0);
+    file << "\n]}\n";
+    LOG("Tracer::exported " + path);
+    return true;
+}
+
+// Writes the scopes ending at or after the given time as trace events, each
+// preceded by a comma, so the caller opens the array with an event of its own.
+// Events overwritten while they were copied are dropped, the head is read
+// again after the copy to find them. The slot of the oldest one left is the
+// slot its thread may be writing, so that event is dropped as well.
+void Tracer::writeChromeEvents(std::ostream& file, int64_t sinceNs) {
+    VECTOR<Ring*>  rings;
+    VECTOR<STRING> threadNames;
+    {
+        std::lock_guard<std::mutex> lock(RingsMutex());
+        rings = Rings();
+        for (Ring* pRing : rings) threadNames.push_back(pRing->threadName);
+    }
+    
+    for (uint r = 0; r < rings.size(); r++) {
+        Ring*    pRing = rings[r];
+        uint64_t head  = pRing->head.load(std::memory_order_acquire);
+        VECTOR<Event> events(pRing->events, pRing->events + TRACE_RING_SIZE);
+        uint64_t after = pRing->head.load(std::memory_order_acquire);
+        uint64_t begin = after >= TRACE_RING_SIZE ? after - TRACE_RING_SIZE + 1 : 0;
+        
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+             << pRing->threadId << ",\"args\":{\"name\":\"" << threadNames[r] << "\"}}";
+        
+        for (uint64_t i = begin; i < head; i++) {
+            Event& event = events[i % TRACE_RING_SIZE];
+            if (event.start + event.duration < sinceNs) continue;
+            file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << pRing->threadId
+                 << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+        }
+    }
+}
+
+// ns since the tracer epoch, the clock of every exported event
+int64_t Tracer::toTraceTime(TimeVal time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - Epoch()).count();
+}
+
+// Total ms of every scope name started at or after the given time, summed
+// over all threads. Rings are in order of scope end and are walked back from
+// their head until a scope ended before that time. The walk stops at the
+// slot its thread writes next, and at any slot the thread reached meanwhile.
+std::map<STRING, float> Tracer::sumSince(TimeVal since) {
+    int64_t sinceNs = toTraceTime(since);
+    std::map<STRING, float> totals;
+    std::lock_guard<std::mutex> lock(RingsMutex());
+    for (Ring* pRing : Rings()) {
+        uint64_t head = pRing->head.load(std::memory_order_acquire);
+        uint64_t end  = head >= TRACE_RING_SIZE ? head - TRACE_RING_SIZE + 1 : 0;
+        for (uint64_t i = head; i > end; i--) {
+            Event event = pRing->events[(i - 1) % TRACE_RING_SIZE];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (pRing->head.load(std::memory_order_relaxed) >= i - 1 + TRACE_RING_SIZE) break;
+            if (event.start + event.duration < sinceNs) break;
+            if (event.start < sinceNs) continue;
+            totals[event.name] += event.duration / 1000000.f;
+        }
+    }
+    return totals;
+}
+
+// Private ==================================================
+
+// Rings are registered once per thread and never freed, so the exporter can
+// still read the ones of finished threads
+Tracer::Ring* Tracer::ThreadRing() {
+    static thread_local Ring* pRing = nullptr;
+    if (pRing) return pRing;
+    
+    pRing = new Ring();
+    std::lock_guard<std::mutex> lock(RingsMutex());
+    pRing->threadId   = UINT32(Rings().size());
+    pRing->threadName = "thread " + std::to_string(pRing->threadId);
+    Rings().push_back(pRing);
+    return pRing;
+}
+
+std::mutex& Tracer::RingsMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+VECTOR<Tracer::Ring*>& Tracer::Rings() {
+    static VECTOR<Ring*> rings;
+    return rings;
+}
+
+TimeVal Tracer::Epoch() {
+    static TimeVal epoch = ChronoTime::now();
+    return epoch;
+}
@@ -0,0 +1,63 @@
+//  Copyright © 2022 Subph. All rights reserved.
+//
+
+#pragma once
+
+#include "include.h"
+
+#include <atomic>
+#include <mutex>
+
+#define TRACE_RING_SIZE 8192
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name)   TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+// CPU timing of named scopes. Every thread records into its own ring, written
+// only by that thread, so recording takes no lock. The rings keep the last
+// TRACE_RING_SIZE scopes per thread and are exported as a Chrome trace.
+class Tracer {
+    
+    struct Event {
+        const char* name;
+        int64_t     start;    // ns since the tracer epoch
+        int64_t     duration; // ns
+    };
+    
+    struct Ring {
+        STRING                threadName;
+        uint                  threadId = 0;
+        std::atomic<uint64_t> head{0};
+        Event                 events[TRACE_RING_SIZE];
+    };
+    
+public:
+    static void setThreadName(STRING name);
+    static void record(const char* name, TimeVal start, TimeVal end);
+    static bool exportChromeTrace(STRING path);
+    static void writeChromeEvents(std::ostream& file, int64_t sinceNs);
+    static int64_t toTraceTime(TimeVal time);
+    static std::map<STRING, float> sumSince(TimeVal since);
+    
+private:
+    static Ring* ThreadRing();
+    static std::mutex& RingsMutex();
+    static VECTOR<Ring*>& Rings();
+    static TimeVal Epoch();
+    
+};
+
+// Records the time between its construction and the end of the enclosing
+// block. The name must outlive the tracer, string literals are expected.
+class TraceScope {
+    
+public:
+    ~TraceScope() { Tracer::record(m_name, m_start, ChronoTime::now()); }
+    TraceScope(const char* name) : m_name(name), m_start(ChronoTime::now()) {}
+    
+private:
+    const char* m_name;
+    TimeVal     m_start;
+    
+};
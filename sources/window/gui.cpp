@@ -44,7 +44,9 @@ void GUI::initGUI(Window* pWindow, Renderpass* pRenderpass) {
     addTexturePrev(pFiles->getTexturePreviews());
 }
 
-void GUI::renderGUI(VkCommandBuffer cmdBuffer) {
+// Builds the draw data on the main thread, GLFW input can only be read there
+void GUI::buildGUI() {
+    TRACE_SCOPE("build gui");
     Settings* settings = System::Settings();
     
     ImGui_ImplVulkan_NewFrame();
@@ -58,6 +60,9 @@ void GUI::renderGUI(VkCommandBuffer cmdBuffer) {
     drawTransparentWindow();
     
     ImGui::Render();
+}
+
+void GUI::renderGUI(VkCommandBuffer cmdBuffer) {
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmdBuffer);
 }
 
@@ -83,9 +88,9 @@ void GUI::drawTransparentWindow() {
     ImGui::SetNextWindowSize(ImVec2(600, 120), ImGuiCond_Once);
     ImGui::Begin("Label Text", nullptr, ImGuiWindowFlags_NoTitleBar);
     ImGui::SetWindowFontScale(1.2);
-    ImGui::Image(m_heightMapTexID, {100, 100});
+    ImGui::Image(m_heightMapTexIDs[m_simulationSlot], {100, 100});
     ImGui::SameLine();
-    ImGui::Image(m_iridescentTexID, {100, 100});
+    ImGui::Image(m_iridescentTexIDs[m_simulationSlot], {100, 100});
     
     ImGui::End();
 }
@@ -103,6 +108,36 @@ void GUI::drawStatusWindow() {
     ImGui::Text("FPS %.1f (%.3f ms/fr)",
                 ImGui::GetIO().Framerate,
                 1000.0f / ImGui::GetIO().Framerate);
+    ImGui::Text("Barriers %u in %u calls",
+                System::Device()->getBarrierCount(),
+                System::Device()->getBarrierCallCount());
+    ImGui::Text("Retired resources %u", System::DeletionQueue()->getPendingCount());
+    if (AllocTracker::isEnabled()) {
+        AllocTracker::FrameStats allocs = AllocTracker::getLastFrame();
+        ImGui::Text("Heap %llu allocs %llu B /fr",
+                    (unsigned long long) allocs.allocations,
+                    (unsigned long long) allocs.bytes);
+        ImGui::Text("Allocating frames %llu",
+                    (unsigned long long) AllocTracker::getAllocatingFrames());
+    }
+    StallAuditor::FrameStats stalls = StallAuditor::getLastFrame();
+    const StallAuditor::Stats& waits = stalls.kinds[StallAuditor::Wait];
+    ImGui::Text("GPU waits %llu (%.3f ms) submits %llu /fr",
+                (unsigned long long) waits.count, waits.ms,
+                (unsigned long long) stalls.kinds[StallAuditor::Submit].count);
+    ImGui::SetNextItemWidth(80);
+    ImGui::DragFloat("Hitch ms", &settings->HitchThreshold, 1.f, 0.f, 1000.f, "%.0f");
+    ImGui::SameLine();
+    ImGui::Text("dumps %u", HitchRecorder::getDumpCount());
+    if (ImGui::Button("Export Trace")) {
+        LOG("Button::Export Trace");
+        settings->BtnExportTrace = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Stall Report")) {
+        LOG("Button::Stall Report");
+        settings->BtnStallReport = true;
+    }
     
     ImGui::Checkbox("Focus,", &settings->LockFocus);
     ImGui::SameLine();
@@ -181,12 +216,82 @@ void GUI::drawStatusWindow() {
         }
     }
     
+    ImGui::Separator();
+    if (ImGui::CollapsingHeader("GPU Timings")) drawProfilers();
+    if (ImGui::CollapsingHeader("Memory")) drawMemory();
+    
     ImGui::Separator();
     ImGui::Checkbox("Show ImGUI demo", &settings->ShowDemo);
     
     ImGui::End();
 }
 
+// A rolling graph per scope, then min, average and 99th percentile in ms.
+// Stats are refilled into lists kept per profiler, so drawing does not allocate.
+void GUI::drawProfilers() {
+    m_profilerStats.resize(m_pProfilers.size());
+    for (uint i = 0; i < m_pProfilers.size(); i++) {
+        GPUProfiler* pProfiler = m_pProfilers[i];
+        VECTOR<GPUProfiler::ScopeStats>& stats = m_profilerStats[i];
+        pProfiler->getStats(&stats);
+        if (stats.empty()) continue;
+        ImGui::Text("%s", pProfiler->getName().c_str());
+        
+        ImGui::PushID(pProfiler);
+        for (GPUProfiler::ScopeStats& scope : stats) {
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "%s %.3f ms", scope.name.c_str(), scope.last);
+            ImGui::PushID(scope.name.c_str());
+            ImGui::PlotLines("##plot", scope.history.data(), int(scope.history.size()), 0,
+                             overlay, 0.f, scope.p99 * 1.25f, ImVec2(0, 32));
+            ImGui::PopID();
+        }
+        ImGui::PopID();
+        
+        if (!ImGui::BeginTable(pProfiler->getName().c_str(), 4,
+                               ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) continue;
+        ImGui::TableSetupColumn("Pass");
+        ImGui::TableSetupColumn("Min");
+        ImGui::TableSetupColumn("Avg");
+        ImGui::TableSetupColumn("P99");
+        ImGui::TableHeadersRow();
+        for (GPUProfiler::ScopeStats& scope : stats) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", scope.name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.min);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.avg);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.p99);
+        }
+        ImGui::EndTable();
+    }
+}
+
+// Usage against budget per heap, then what the app allocated per tag in MB
+void GUI::drawMemory() {
+    Settings* settings = System::Settings();
+    Device*   pDevice  = System::Device();
+    const float mb = 1024.f * 1024.f;
+    
+    const VECTOR<Device::HeapBudget>& heaps = pDevice->getHeapBudgets();
+    for (uint i = 0; i < heaps.size(); i++) {
+        const Device::HeapBudget& heap = heaps[i];
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.0f / %.0f MB", heap.usage / mb, heap.budget / mb);
+        ImGui::Text("Heap %u%s", i, heap.deviceLocal ? " local" : "");
+        ImGui::ProgressBar(heap.budget > 0 ? FLOAT(heap.usage) / heap.budget : 0.f, ImVec2(-1, 0), overlay);
+    }
+    if (!pDevice->hasMemoryBudget()) ImGui::Text("No VK_EXT_memory_budget, app usage only");
+    
+    for (uint i = 0; i < MEMORY_TAG_COUNT; i++) {
+        MemoryTag tag = MemoryTag(i);
+        ImGui::Text("%-8s %8.1f MB", Device::MemoryTagName(tag), pDevice->getTaggedMemory(tag) / mb);
+    }
+    if (ImGui::Button("Export Memory")) {
+        LOG("Button::Export Memory");
+        settings->BtnExportMemory = true;
+    }
+}
+
 void GUI::drawImageWindow() {
     Settings* settings = System::Settings();
     Files* pFiles = System::Files();
@@ -200,15 +305,15 @@ void GUI::drawImageWindow() {
     ImGui::Checkbox("Simulate Rain", &settings->RunRain);
     if (ImGui::BeginTabBar("FluidTabBar")) {
         if (ImGui::BeginTabItem("Height")) {
-            ImGui::Image(m_heightMapTexID, {234, 234});
+            ImGui::Image(m_heightMapTexIDs[m_simulationSlot], {234, 234});
             ImGui::EndTabItem();
         }
         if (ImGui::BeginTabItem("Fluid")) {
-            ImGui::Image(m_fluidTexID, {234, 234});
+            ImGui::Image(m_fluidTexIDs[m_simulationSlot], {234, 234});
             ImGui::EndTabItem();
         }
         if (ImGui::BeginTabItem("Iridesence")) {
-            ImGui::Image(m_iridescentTexID, {234, 234});
+            ImGui::Image(m_iridescentTexIDs[m_simulationSlot], {234, 234});
             ImGui::EndTabItem();
         }
         ImGui::EndTabBar();
@@ -267,21 +372,38 @@ void GUI::addMarkedImage(Image* pImage) {
     m_markedTexID = (ImTextureID)ImGui_ImplVulkan_CreateTexture(pImage->getSampler(), pImage->getImageView(), pImage->getImageLayout());
 }
 
-void GUI::updateHeightMapImage(Image* pImage) {
-    pImage->cmdTransitionToShaderR();
-    m_heightMapTexID = (ImTextureID)ImGui_ImplVulkan_CreateTexture(pImage->getSampler(), pImage->getImageView(), pImage->getImageLayout());
+void GUI::updateHeightMapImages(VECTOR<Image*> pImages) {
+    m_heightMapTexIDs.clear();
+    for (Image* pImage : pImages) {
+        pImage->cmdTransitionToShaderR();
+        ImTextureID texID = (ImTextureID)ImGui_ImplVulkan_CreateTexture(pImage->getSampler(), pImage->getImageView(), pImage->getImageLayout());
+        m_heightMapTexIDs.push_back(texID);
+    }
 }
 
-void GUI::updateIridescentImage(Image* pImage) {
-    pImage->cmdTransitionToShaderR();
-    m_iridescentTexID = (ImTextureID)ImGui_ImplVulkan_CreateTexture(pImage->getSampler(), pImage->getImageView(), pImage->getImageLayout());
+void GUI::updateIridescentImages(VECTOR<Image*> pImages) {
+    m_iridescentTexIDs.clear();
+    for (Image* pImage : pImages) {
+        pImage->cmdTransitionToShaderR();
+        ImTextureID texID = (ImTextureID)ImGui_ImplVulkan_CreateTexture(pImage->getSampler(), pImage->getImageView(), pImage->getImageLayout());
+        m_iridescentTexIDs.push_back(texID);
+    }
 }
 
-void GUI::updateFluidImage(Image* pImage) {
-    pImage->cmdTransitionToShaderR();
-    m_fluidTexID = (ImTextureID)ImGui_ImplVulkan_CreateTexture(pImage->getSampler(), pImage->getImageView(), pImage->getImageLayout());
+void GUI::updateFluidImages(VECTOR<Image*> pImages) {
+    m_fluidTexIDs.clear();
+    for (Image* pImage : pImages) {
+        pImage->cmdTransitionToShaderR();
+        ImTextureID texID = (ImTextureID)ImGui_ImplVulkan_CreateTexture(pImage->getSampler(), pImage->getImageView(), pImage->getImageLayout());
+        m_fluidTexIDs.push_back(texID);
+    }
 }
 
+// The fluid views show the slot the current frame waits on
+void GUI::setSimulationSlot(uint slot) { m_simulationSlot = slot; }
+
+void GUI::addProfiler(GPUProfiler* pProfiler) { m_pProfilers.push_back(pProfiler); }
+
 void GUI::addCubemapImage(Image* pImage) {
     m_cubemapTexID = (ImTextureID)ImGui_ImplVulkan_CreateTexture(pImage->getSampler(), pImage->getImageView(), pImage->getImageLayout());
 }
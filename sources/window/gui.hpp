@@ -7,6 +7,7 @@
 #include "window.hpp"
 #include "../renderer/renderpass.hpp"
 #include "../resources/image.hpp"
+#include "../renderer/gpu_profiler.hpp"
 
 #include "../extensions/ext_imgui.h"
 
@@ -19,13 +20,16 @@ public:
     void cleanupGUI();
 
     void initGUI(Window* pWindow, Renderpass* pRenderpass);
+    void buildGUI();
     void renderGUI(VkCommandBuffer cmdBuffer);
     
     void addInterferenceImage(Image* pImage);
     void addMarkedImage(Image* pImage);
-    void updateHeightMapImage(Image* pImage);
-    void updateIridescentImage(Image* pImage);
-    void updateFluidImage(Image* pImage);
+    void updateHeightMapImages(VECTOR<Image*> pImages);
+    void updateIridescentImages(VECTOR<Image*> pImages);
+    void updateFluidImages(VECTOR<Image*> pImages);
+    void setSimulationSlot(uint slot);
+    void addProfiler(GPUProfiler* pProfiler);
     
     void addCubemapImage(Image* pImage);
     void addTextureImage(Image* pImage);
@@ -39,13 +43,18 @@ private:
     
     ImTextureID m_interferenceTexID;
     ImTextureID m_markedTexID;
-    ImTextureID m_fluidTexID;
-    ImTextureID m_heightMapTexID;
-    ImTextureID m_iridescentTexID;
+    // Per simulation slot
+    uint m_simulationSlot = 0;
+    VECTOR<ImTextureID> m_fluidTexIDs;
+    VECTOR<ImTextureID> m_heightMapTexIDs;
+    VECTOR<ImTextureID> m_iridescentTexIDs;
     
     VECTOR<ImTextureID> m_cubemapPrevID;
     VECTOR<ImTextureID> m_texturePrevID;
     
+    VECTOR<GPUProfiler*> m_pProfilers;
+    VECTOR<VECTOR<GPUProfiler::ScopeStats>> m_profilerStats;
+    
     ImTextureID m_textureTexID;
     ImTextureID m_cubemapTexID;
     
@@ -53,6 +62,8 @@ private:
     
     void changeStyle();
     void drawStatusWindow();
+    void drawProfilers();
+    void drawMemory();
     void drawImageWindow();
     void drawTransparentWindow();
 };